@@ -0,0 +1,403 @@
+// blitgen - unrolled per sprite blit procs generated from the stripe tables of a .gasm
+//
+// Build: cc -O2 -o blitgen blitgen.c
+// Usage: blitgen [-c costs.txt] <sugarglider.gasm> <name:first:count[:from]>...
+//
+// The runtime's drawBlit walks the sprite's zero terminated <stripe> <offset>
+// table from _blitsLut_ for every stripe, every time it is drawn. For every
+// group, (e.g. glider:0:6 for blits 0 to 5), this prints gtBASIC procs that
+// SYS_Sprite6_v3_64 each stripe of each frame with the offsets unrolled: name0
+// to name<count-1>, a "dim name_t" table of them and a dispatcher "name" that
+// blits frame bf at the screen address in bx, (the caller packs bx.lo = x and
+// bx.hi = y + 8, like the blit statement packs blitXY), plus one blitinit proc
+// that fills every table, (call it once at startup). The dispatchers don't
+// load giga_sysFn, blitbegin does that once for a batch of them, so a batch
+// must not contain other SYS calls, (the runtime's % and / included). The
+// output replaces everything between the "'blitgen begin" and "'blitgen end"
+// lines of the source.
+//
+// A group with :from also gets "namefrom1" to "namefrom<from>" dispatchers,
+// "name_t1"... tables and frame procs "name<f>from<k>" that blit stripe k on,
+// for a sprite hanging off the left edge of the screen. They are procs of
+// their own, entering a frame proc part way would skip its vLR PUSH and its
+// POP would then take the dispatcher's. Sprite6 writes a whole
+// stripe and the 96 bytes right of every screen line hold code and data, so a
+// stripe is only drawn when all of it is on screen. For those bx is stripe 0's
+// 16 bit address, ((y + 8) LSL 8) + x with a negative x, and the stripe offset
+// carries it back onto the right line. It gets "nameto0" as well, which draws
+// stripe 0 alone for a sprite hanging off the right edge, straight from the
+// blit's own lut in _blitsLut_.
+//
+// No stripe address is baked in, every stripe starts with an LDWI 0 that
+// blitinit patches with the address from the running image's own _blitsLut_,
+// so moving code, arrays or stripes around needs no rerun. Only the number of
+// stripes per frame and their offsets come from the .gasm, which depend on the
+// images alone, so rerun it when a load blit is added, removed or resized. The
+// procs only use v5a opcodes.
+//
+// The instruction counts of the runtime path and the generated path, (from the
+// blit call to the return, SYS budgets and blitbegin's 6 instructions per
+// batch excluded), are printed to stderr per frame, weighted with -c by a
+// romcost style cycle table of "<rom|*> <opcode> <cycles>" lines, (the ROMvX0
+// and "*" entries are used).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BLITS   64
+#define MAX_STRIPES 32
+#define MAX_GROUPS  16
+#define MAX_LUTS    64
+#define MAX_COSTS   256
+#define SYS_CYCLES  64
+
+typedef struct {
+    uint16_t addr;
+    int numStripes;
+    uint16_t stripe[MAX_STRIPES];
+    uint16_t offset[MAX_STRIPES];
+} lut_t;
+
+typedef struct {
+    char name[32];
+    int first, count;
+    int from;                           // last stripe with an edge clipped entry, 0 for none
+} group_t;
+
+typedef struct {
+    char opcode[16];
+    int cycles;
+} cost_t;
+
+static uint16_t blitsLut[MAX_BLITS];
+static int numBlits = 0;
+static lut_t luts[MAX_LUTS];
+static int numLuts = 0;
+static group_t groups[MAX_GROUPS];
+static int numGroups = 0;
+static cost_t costs[MAX_COSTS];
+static int numCosts = 0;
+
+// The runtime path, drawBlit_ from blit_ROMvX0.i called through the DrawBlit macro, and the per stripe part
+static const char *runtimeFixed[] = {"CALLI", "PUSH", "LDWI", "STW", "CALLI", "ARRVW", "DEEKA", "BRA", "DEEKV+", "BNE", "RET", "POP", "RET", NULL};
+static const char *runtimeStripe[] = {"STW", "DEEKV+", "ADDW", "DEEKV+", "BNE", NULL};
+
+// The generated path, the dispatcher and one frame proc with their proc prologues and epilogues, (the first stripe's
+// LDW _bx has no ADDI)
+static const char *genFixed[] = {"CALLI", "PUSH", "LDWI", "ADDW", "ADDW", "DEEK", "CALL", "PUSH", "POP", "RET", "POP", "RET", NULL};
+static const char *genStripe[] = {"LDWI", "STW", "LDW", "ADDI", NULL};
+
+static int loadCosts(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "blitgen: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[256], rom[16], opcode[16];
+    int cycles;
+    while (fgets(line, sizeof(line), fp) && numCosts < MAX_COSTS) {
+        if (line[0] == '#' || sscanf(line, "%15s %15s %d", rom, opcode, &cycles) != 3) continue;
+        if (strcmp(rom, "*") != 0 && strcmp(rom, "ROMvX0") != 0) continue;
+
+        // a ROMvX0 entry wins over a "*" one
+        int i;
+        for (i = 0; i < numCosts && strcmp(costs[i].opcode, opcode) != 0; i++);
+        if (i < numCosts && strcmp(rom, "*") == 0) continue;
+        snprintf(costs[i].opcode, sizeof(costs[i].opcode), "%s", opcode);
+        costs[i].cycles = cycles;
+        if (i == numCosts) numCosts++;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int cost(const char *opcode) {
+    for (int i = 0; i < numCosts; i++) {
+        if (strcmp(costs[i].opcode, opcode) == 0) return costs[i].cycles;
+    }
+    if (numCosts) fprintf(stderr, "blitgen: no cycles for %s, counted as 0\n", opcode);
+    return 0;
+}
+
+static void pathCost(const char **fixed, const char **stripe, int numStripes, int *insns, int *cycles) {
+    *insns = *cycles = 0;
+    for (int i = 0; fixed[i]; i++) {
+        (*insns)++;
+        *cycles += cost(fixed[i]);
+    }
+    for (int i = 0; stripe[i]; i++) {
+        *insns += numStripes;
+        *cycles += numStripes*cost(stripe[i]);
+    }
+}
+
+// "_blitsLut_  DW  0x6ca9 0x6ba9..." and "_blitLut_0x6ca9  DW  0x7fab 0x0000 0x7eab 0x0006 0x0000"
+static int loadGasm(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "blitgen: can't open '%s'\n", path);
+        return 0;
+    }
+
+    static char line[4096];
+    while (fgets(line, sizeof(line), fp)) {
+        char label[64], directive[16];
+        int used;
+        if (sscanf(line, "%63s %15s%n", label, directive, &used) != 2 || strcmp(directive, "DW") != 0) continue;
+
+        char *p = line + used, *end;
+        if (strcmp(label, "_blitsLut_") == 0) {
+            for (long v = strtol(p, &end, 0); end != p && numBlits < MAX_BLITS; v = strtol(p, &end, 0)) {
+                blitsLut[numBlits++] = (uint16_t)v;
+                p = end;
+            }
+        } else if (strncmp(label, "_blitLut_", 9) == 0 && numLuts < MAX_LUTS) {
+            lut_t *lut = &luts[numLuts++];
+            lut->addr = (uint16_t)strtol(label + 9, NULL, 0);
+            lut->numStripes = 0;
+            for (;;) {
+                long stripe = strtol(p, &end, 0);
+                if (end == p || stripe == 0) break;
+                p = end;
+                long offset = strtol(p, &end, 0);
+                if (end == p || lut->numStripes == MAX_STRIPES) break;
+                p = end;
+                lut->stripe[lut->numStripes] = (uint16_t)stripe;
+                lut->offset[lut->numStripes++] = (uint16_t)offset;
+            }
+        }
+    }
+
+    fclose(fp);
+    if (!numBlits) {
+        fprintf(stderr, "blitgen: '%s' has no _blitsLut_\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+static lut_t *findLut(int id) {
+    for (int i = 0; i < numLuts; i++) {
+        if (luts[i].addr == blitsLut[id]) return &luts[i];
+    }
+    return NULL;
+}
+
+// Frame proc name<f>, or name<f>from<k> for stripes k on, every stripe labelled for blitinit
+static void printFrame(const group_t *g, int frame, const lut_t *lut, int k) {
+    char proc[64];
+    if (k) {
+        snprintf(proc, sizeof(proc), "%.31s%dfrom%d", g->name, frame, k);
+    } else {
+        snprintf(proc, sizeof(proc), "%.31s%d", g->name, frame);
+    }
+    printf("proc %s\n", proc);
+    printf("asm\n");
+    for (int i = k; i < lut->numStripes; i++) {
+        printf("%s_%d\n", proc, i);
+        printf("        LDWI    0x0000                          ; blit %d stripe %d, patched by blitinit\n", g->first + frame, i);
+        printf("        STW     giga_sysArg0\n");
+        printf("        LDW     _bx\n");
+        if (lut->offset[i]) printf("        ADDI    %d\n", lut->offset[i]);
+        printf("        SYS     %d\n", SYS_CYCLES);
+    }
+    printf("endasm\n");
+    printf("endproc\n\n");
+}
+
+// Points every stripe's LDWI at the stripe the running image's _blitsLut_ has for it, (bw walks the
+// <stripe> <offset> pairs, by is the LDWI's operand)
+static void printPatch(const group_t *g) {
+    for (int f = 0; f < g->count; f++) {
+        for (int k = 0; k <= g->from; k++) {
+            printf("        LDWI    _blitsLut_ + %d\n", (g->first + f)*2);
+            printf("        DEEK\n");
+            if (k) printf("        ADDI    %d\n", k*4);
+            printf("        STW     _bw\n");
+            for (int i = k; i < findLut(g->first + f)->numStripes; i++) {
+                if (k) {
+                    printf("        LDWI    %s%dfrom%d_%d + 1\n", g->name, f, k, i);
+                } else {
+                    printf("        LDWI    %s%d_%d + 1\n", g->name, f, i);
+                }
+                printf("        STW     _by\n");
+                printf("        CALLI   _blitpatch\n");
+            }
+        }
+    }
+}
+
+// Stripe 0 of frame bf goes to bx, so from stripe k on the bx of a sprite hanging off the left edge is a row up
+// and x + 256, (the 16 bit offset of stripe k carries it back onto the right row)
+static void printGroup(const group_t *g, int k) {
+    if (k) {
+        printf("'blits %d to %d from stripe %d on, frame bf with stripe 0 at the screen address in bx, (bx = ((y + 8) LSL 8) + x, x < 0)\n",
+               g->first, g->first + g->count - 1, k);
+        printf("proc %sfrom%d\n", g->name, k);
+    } else {
+        printf("'blits %d to %d, frame bf at the screen address in bx, (bx.lo = x, bx.hi = y + 8)\n", g->first, g->first + g->count - 1);
+        printf("proc %s\n", g->name);
+    }
+    printf("asm\n");
+    if (k) {
+        printf("        LDWI    _%s_t%d\n", g->name, k);
+    } else {
+        printf("        LDWI    _%s_t\n", g->name);
+    }
+    printf("        ADDW    _bf\n");
+    printf("        ADDW    _bf\n");
+    printf("        DEEK\n");
+    printf("        CALL    giga_vAC\n");
+    printf("endasm\n");
+    printf("endproc\n\n");
+}
+
+// Stripe 0 alone, the first word of the frame's <stripe> <offset> lut, every frame's stripe 0 offset is checked to match
+static void printTo0(const group_t *g) {
+    printf("'blits %d to %d stripe 0 only, frame bf at the screen address in bx, for a sprite hanging off the right edge\n",
+           g->first, g->first + g->count - 1);
+    printf("proc %sto0\n", g->name);
+    printf("asm\n");
+    printf("        LDWI    _blitsLut_ + %d\n", g->first*2);
+    printf("        ADDW    _bf\n");
+    printf("        ADDW    _bf\n");
+    printf("        DEEK\n");
+    printf("        DEEK                                    ; stripe 0\n");
+    printf("        STW     giga_sysArg0\n");
+    printf("        LDW     _bx\n");
+    if (findLut(g->first)->offset[0]) printf("        ADDI    %d\n", findLut(g->first)->offset[0]);
+    printf("        SYS     %d\n", SYS_CYCLES);
+    printf("endasm\n");
+    printf("endproc\n\n");
+}
+
+// Fills name_t with the frame procs, or name_t<k> with their stripe k on procs
+static void printFill(const group_t *g, int k) {
+    if (k) {
+        printf("\tp = @%s_t%d\n", g->name, k);
+    } else {
+        printf("\tp = @%s_t\n", g->name);
+    }
+    printf("asm\n");
+    for (int f = 0; f < g->count; f++) {
+        if (k) {
+            printf("        LDWI    _%s%dfrom%d\n", g->name, f, k);
+        } else {
+            printf("        LDWI    _%s%d\n", g->name, f);
+        }
+        printf("        DOKE    _blitinit_p\n");
+        if (f == g->count - 1) break;
+        printf("        LDW     _blitinit_p\n");
+        printf("        ADDI    2\n");
+        printf("        STW     _blitinit_p\n");
+    }
+    printf("endasm\n");
+}
+
+int main(int argc, char *argv[]) {
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "-c") == 0) {
+        if (!loadCosts(argv[arg + 1])) return 1;
+        arg += 2;
+    }
+
+    if (arg + 1 >= argc) {
+        fprintf(stderr, "Usage: blitgen [-c costs.txt] <sugarglider.gasm> <name:first:count[:from]>...\n");
+        return 1;
+    }
+    const char *gasm = argv[arg++];
+    if (!loadGasm(gasm)) return 1;
+
+    for (; arg < argc && numGroups < MAX_GROUPS; arg++) {
+        group_t *g = &groups[numGroups];
+        g->from = 0;
+        if (sscanf(argv[arg], "%31[a-z0-9]:%d:%d:%d", g->name, &g->first, &g->count, &g->from) < 3 || g->count < 1 || g->from < 0) {
+            fprintf(stderr, "blitgen: '%s' isn't name:first:count[:from]\n", argv[arg]);
+            return 1;
+        }
+        for (int id = g->first; id < g->first + g->count; id++) {
+            if (id < 0 || id >= numBlits || !findLut(id)) {
+                fprintf(stderr, "blitgen: blit %d isn't in '%s'\n", id, gasm);
+                return 1;
+            }
+            if (g->from >= findLut(id)->numStripes) {
+                fprintf(stderr, "blitgen: blit %d has no stripe %d\n", id, g->from);
+                return 1;
+            }
+            if (g->from && findLut(id)->offset[0] != findLut(g->first)->offset[0]) {
+                fprintf(stderr, "blitgen: blit %d's stripe 0 offset differs from blit %d's\n", id, g->first);
+                return 1;
+            }
+        }
+        numGroups++;
+    }
+
+    printf("'blitgen begin, generated by tools/blitgen from %s, rerun it when a blit's image changes\n", strrchr(gasm, '/') ? strrchr(gasm, '/') + 1 : gasm);
+    for (int i = 0; i < numGroups; i++) {
+        printf("dim %s_t(%d)\n", groups[i].name, groups[i].count - 1);
+        for (int k = 1; k <= groups[i].from; k++) printf("dim %s_t%d(%d)\n", groups[i].name, k, groups[i].count - 1);
+    }
+    printf("\n");
+
+    printf("'loads SYS_Sprite6_v3_64 for a batch of blits, the dispatchers don't, so from here to the last blit of the batch\n");
+    printf("'nothing may load another giga_sysFn: no clearbox, no runtime %%, /, * or print and no SYS in the real time procs,\n");
+    printf("'(stackcheck reports those), call it again after any of them\n");
+    printf("proc blitbegin\n");
+    printf("asm\n");
+    printf("        LDWI    SYS_Sprite6_v3_64\n");
+    printf("        STW     giga_sysFn\n");
+    printf("endasm\n");
+    printf("endproc\n\n");
+
+    printf("'copies the stripe address at bw into the LDWI operand at by and moves bw on to the next stripe\n");
+    printf("proc blitpatch\n");
+    printf("asm\n");
+    printf("        LDW     _bw\n");
+    printf("        DEEK\n");
+    printf("        DOKE    _by\n");
+    printf("        LDW     _bw\n");
+    printf("        ADDI    4\n");
+    printf("        STW     _bw\n");
+    printf("endasm\n");
+    printf("endproc\n\n");
+
+    printf("proc blitinit\n");
+    printf("\tlocal p\n\t\n");
+    for (int i = 0; i < numGroups; i++) {
+        for (int k = 0; k <= groups[i].from; k++) printFill(&groups[i], k);
+    }
+    printf("\t\n\t'stripe addresses from this compile's own blit tables\n");
+    printf("asm\n");
+    for (int i = 0; i < numGroups; i++) printPatch(&groups[i]);
+    printf("endasm\n");
+    printf("endproc\n\n");
+
+    fprintf(stderr, "%-12s %4s %7s %8s %8s %6s\n", "frame", "blit", "stripes", "runtime", "unrolled", "saved");
+    for (int i = 0; i < numGroups; i++) {
+        const group_t *g = &groups[i];
+        for (int k = 0; k <= g->from; k++) printGroup(g, k);
+        if (g->from) printTo0(g);
+        for (int f = 0; f < g->count; f++) {
+            const lut_t *lut = findLut(g->first + f);
+            for (int k = 0; k <= g->from; k++) printFrame(g, f, lut, k);
+
+            int ri, rc, gi, gc;
+            pathCost(runtimeFixed, runtimeStripe, lut->numStripes, &ri, &rc);
+            pathCost(genFixed, genStripe, lut->numStripes, &gi, &gc);
+            if (lut->offset[0] == 0) {
+                gi--;
+                gc -= cost("ADDI");
+            }
+            int r = numCosts ? rc : ri, u = numCosts ? gc : gi;
+            fprintf(stderr, "%-10.10s%2d %4d %7d %8d %8d %6d\n", g->name, f, g->first + f, lut->numStripes, r, u, r - u);
+        }
+    }
+    fprintf(stderr, "(%s, SYS budgets excluded)\n", numCosts ? "cycles" : "vCPU instructions");
+    printf("'blitgen end\n");
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+// gt1load - simulated Loader time per GT1 segment, with segment merging and reordering
+//
+// Build: cc -O2 -o gt1load gt1load.c
+// Usage: gt1load [-g gap] [-k addr:size]... <in.gt1> [out.gt1]
+//
+// The Loader receives one packet per video frame and a packet carries at most
+// 60 bytes of a single segment, so a segment costs ceil(size/60) frames no
+// matter how few bytes it has, plus one final frame for the execute packet.
+//
+// Segments in the same page whose gap is no larger than -g bytes are merged,
+// (the gap is zero filled), when that saves at least one packet. Pages 0 and 1
+// are never merged, their gaps are live variables, the stack and the video
+// table, which a zero fill would clobber. A gap never covers the
+// hiscore table at 0x08A0:8, which must survive a reload, and -k protects any
+// further range the same way. The output image lists the page holding the
+// execute address first, (after any page 0 segment, which must lead), then the
+// rest in ascending address order. The Loader only jumps to the execute address
+// after the last packet, so ordering alone doesn't shorten the load, it only
+// makes the code resident first.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_SIZE     0x10000
+#define MAX_SEGMENTS 256
+#define MAX_KEEPS    16
+#define PAYLOAD_SIZE 60
+#define FRAME_RATE   59.98
+#define HITABLE      0x08A0  // hitable in sugarglider.gbas, the magic word and 3 scores
+#define HITABLE_SIZE 8
+
+typedef struct {
+    uint16_t addr;
+    int size;
+} segment_t;
+
+typedef struct {
+    uint16_t addr;
+    int size;
+} keep_t;
+
+static uint8_t ram[RAM_SIZE];
+static segment_t segments[MAX_SEGMENTS];
+static int numSegments = 0;
+static uint16_t execAddr = 0;
+static keep_t keeps[MAX_KEEPS];
+static int numKeeps = 0;
+
+static int packets(int size) {
+    return (size + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE;
+}
+
+static int loadGt1(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "gt1load: can't open '%s'\n", path);
+        return 0;
+    }
+
+    // segments are <hi> <lo> <size> <data...>, a size of 0 means 256, a <hi> of 0 past the first segment ends the file
+    int hi;
+    while ((hi = fgetc(fp)) != EOF) {
+        if (hi == 0 && numSegments) break;
+        int lo = fgetc(fp), size = fgetc(fp);
+        if (lo == EOF || size == EOF || numSegments == MAX_SEGMENTS) {
+            fprintf(stderr, "gt1load: '%s' is truncated or has too many segments\n", path);
+            fclose(fp);
+            return 0;
+        }
+        if (size == 0) size = 256;
+
+        uint16_t addr = (uint16_t)((hi << 8) | lo);
+        if ((addr & 0xFF) + size > 256) {
+            fprintf(stderr, "gt1load: segment 0x%04x crosses a page boundary\n", addr);
+            fclose(fp);
+            return 0;
+        }
+        if (fread(&ram[addr], 1, size, fp) != (size_t)size) {
+            fprintf(stderr, "gt1load: '%s' is truncated\n", path);
+            fclose(fp);
+            return 0;
+        }
+        segments[numSegments].addr = addr;
+        segments[numSegments++].size = size;
+    }
+
+    int execHi = fgetc(fp), execLo = fgetc(fp);
+    if (execHi == EOF || execLo == EOF) {
+        fprintf(stderr, "gt1load: '%s' has no execute address\n", path);
+        fclose(fp);
+        return 0;
+    }
+    execAddr = (uint16_t)((execHi << 8) | execLo);
+
+    fclose(fp);
+    return 1;
+}
+
+static int saveGt1(const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "gt1load: can't create '%s'\n", path);
+        return 0;
+    }
+
+    for (int i = 0; i < numSegments; i++) {
+        fputc(segments[i].addr >> 8, fp);
+        fputc(segments[i].addr & 0xFF, fp);
+        fputc(segments[i].size & 0xFF, fp);
+        fwrite(&ram[segments[i].addr], 1, segments[i].size, fp);
+    }
+    fputc(0, fp);
+    fputc(execAddr >> 8, fp);
+    fputc(execAddr & 0xFF, fp);
+
+    fclose(fp);
+    return 1;
+}
+
+static void report(const char *title, int verbose) {
+    int bytes = 0, frames = 1;
+    if (verbose) printf("  addr    size  packets\n");
+    for (int i = 0; i < numSegments; i++) {
+        bytes += segments[i].size;
+        frames += packets(segments[i].size);
+        if (verbose) printf("  0x%04x  %4d  %7d\n", segments[i].addr, segments[i].size, packets(segments[i].size));
+    }
+    printf("%-7s %3d segments, %5d bytes, %4d frames, %.2f s\n", title, numSegments, bytes, frames, frames / FRAME_RATE);
+}
+
+// Only the first segment may be in page 0, (a <hi> of 0 anywhere else ends the file)
+static int loadOrder(uint16_t addr) {
+    if ((addr >> 8) == 0) return 0;
+    if ((addr >> 8) == (execAddr >> 8)) return 1;
+    return 2;
+}
+
+static int compareSegments(const void *a, const void *b) {
+    const segment_t *sa = (const segment_t *)a;
+    const segment_t *sb = (const segment_t *)b;
+    int oa = loadOrder(sa->addr), ob = loadOrder(sb->addr);
+    if (oa != ob) return (oa < ob) ? -1 : 1;
+    return (sa->addr < sb->addr) ? -1 : (sa->addr > sb->addr);
+}
+
+static int isKept(int start, int end) {
+    if (start < HITABLE + HITABLE_SIZE && HITABLE < end) return 1;
+    for (int i = 0; i < numKeeps; i++) {
+        if (start < keeps[i].addr + keeps[i].size && keeps[i].addr < end) return 1;
+    }
+    return 0;
+}
+
+static void mergeSegments(int maxGap) {
+    qsort(segments, numSegments, sizeof(segment_t), compareSegments);
+
+    int out = 0;
+    for (int i = 0; i < numSegments; i++) {
+        if (out) {
+            segment_t *prev = &segments[out - 1];
+            int end = prev->addr + prev->size;
+            int gap = segments[i].addr - end;
+            int merged = segments[i].addr + segments[i].size - prev->addr;
+            if ((prev->addr >> 8) == (segments[i].addr >> 8) && (prev->addr >> 8) > 1 && gap >= 0 && gap <= maxGap &&
+                !isKept(end, segments[i].addr) && packets(merged) < packets(prev->size) + packets(segments[i].size)) {
+                memset(&ram[end], 0, gap);
+                prev->size = merged;
+                continue;
+            }
+        }
+        segments[out++] = segments[i];
+    }
+    numSegments = out;
+}
+
+int main(int argc, char *argv[]) {
+    int maxGap = 0, arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-g") == 0 && arg + 1 < argc) {
+            maxGap = (int)strtol(argv[++arg], NULL, 0);
+        } else if (strcmp(argv[arg], "-k") == 0 && arg + 1 < argc && numKeeps < MAX_KEEPS) {
+            char *colon;
+            keeps[numKeeps].addr = (uint16_t)strtol(argv[++arg], &colon, 0);
+            keeps[numKeeps++].size = (*colon == ':') ? (int)strtol(colon + 1, NULL, 0) : 1;
+        } else {
+            break;
+        }
+    }
+
+    if (arg >= argc) {
+        fprintf(stderr, "Usage: gt1load [-g gap] [-k addr:size]... <in.gt1> [out.gt1]\n");
+        return 1;
+    }
+
+    if (!loadGt1(argv[arg])) return 1;
+
+    printf("execute address 0x%04x\n", execAddr);
+    report("before", 1);
+    mergeSegments(maxGap);
+    report("after", 0);
+
+    if (arg + 1 < argc && !saveGt1(argv[arg + 1])) return 1;
+
+    return 0;
+}
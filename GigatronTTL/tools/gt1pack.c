@@ -0,0 +1,319 @@
+// gt1pack - packs the 6 bit blit stripe chunks of a .gt1 into SYS_Unpack_56's 3 bytes per 4 pixels format
+//
+// Build: cc -O2 -o gt1pack gt1pack.c
+// Usage: gt1pack [-a] [-u addr] [-k addr:size]... <sugarglider.gasm> <in.gt1> <out.gt1>
+//
+// Every def_blits_ chunk from the .gasm whose pixels are all below 64 is
+// rewritten in place: its first 3*g bytes hold the g packed groups of 4 pixels,
+// (pixel0 | pixel1<<6 | pixel2<<12 | pixel3<<18, little endian), followed by the
+// 1 to 4 tail bytes, (leftover pixels and the stripe terminator). The chunk's
+// segment shrinks by g bytes and unpackassets in sugarglider.gbas expands it at
+// startup, moving the tail up by g bytes first and then unpacking the groups
+// last to first so no group is overwritten before it is read.
+//
+// The unpack table is a list of 3 byte entries, <dest word> <g | (tail - 1)<<6>,
+// ended by a dest of 0; an entry with g = 0 continues the table at dest. It is
+// placed in offscreen bytes no segment uses and its address is written to the
+// word at -u, (default 0x08A8, the normal build loads a 0 there). The hiscore
+// table at 0x08A0:8 is never loaded, so it is always kept free of table bytes,
+// -k keeps any further range free as well.
+//
+// The Loader is packet bound, (see gt1load), so by default a chunk is only packed
+// when that saves a packet in its page, -a packs every chunk regardless. With
+// nothing worth packing the image is written back unpacked.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_SIZE     0x10000
+#define MAX_CHUNKS   128
+#define MAX_KEEPS    16
+#define PAYLOAD_SIZE 60
+#define FRAME_RATE   59.98
+#define HITABLE      0x08A0  // hitable in sugarglider.gbas, the magic word and 3 scores
+#define HITABLE_SIZE 8
+
+typedef struct {
+    uint16_t addr;
+    int size;
+} range_t;
+
+static uint8_t ram[RAM_SIZE];
+static uint8_t loaded[RAM_SIZE];
+static uint8_t reserved[RAM_SIZE];  // chunk destinations, keeps, the hiscore table and the table pointer
+static range_t chunks[MAX_CHUNKS];
+static int numChunks = 0;
+static range_t keeps[MAX_KEEPS];
+static int numKeeps = 0;
+static uint16_t execAddr = 0;
+
+static int packets(int size) {
+    return (size + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE;
+}
+
+static int loadGasm(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "gt1pack: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[4096], lastLabel[64] = "";
+    int lastAddr = -1;
+    while (fgets(line, sizeof(line), fp) && numChunks < MAX_CHUNKS) {
+        char label[64], op[16], arg[64];
+        if (strncmp(line, "def_blits_", 10) != 0 || sscanf(line, "%63s %15s %63s", label, op, arg) != 3) continue;
+
+        if (strcmp(op, "EQU") == 0) {
+            snprintf(lastLabel, sizeof(lastLabel), "%s", label);
+            lastAddr = (int)strtol(arg, NULL, 0);
+        } else if (strcmp(op, "DB") == 0 && strcmp(label, lastLabel) == 0 && lastAddr >= 0) {
+            int size = 0;
+            for (char *p = strstr(line, "DB") + 2; *p; ) {
+                while (*p == ' ' || *p == '\t') p++;
+                if (!*p || *p == '\r' || *p == '\n' || *p == ';') break;
+                size++;
+                while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+            }
+            chunks[numChunks].addr = (uint16_t)lastAddr;
+            chunks[numChunks++].size = size;
+            lastAddr = -1;
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int loadGt1(const char *path, int *bytes, int *segments, int *frames) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "gt1pack: can't open '%s'\n", path);
+        return 0;
+    }
+
+    // segments are <hi> <lo> <size> <data...>, a size of 0 means 256, a <hi> of 0 past the first segment ends the file
+    int hi;
+    *bytes = *segments = 0;
+    *frames = 1;
+    while ((hi = fgetc(fp)) != EOF) {
+        if (hi == 0 && *segments) break;
+        int lo = fgetc(fp), size = fgetc(fp);
+        if (lo == EOF || size == EOF) break;
+        if (size == 0) size = 256;
+        uint16_t addr = (uint16_t)((hi << 8) | lo);
+        if (fread(&ram[addr], 1, size, fp) != (size_t)size) break;
+        memset(&loaded[addr], 1, size);
+        *bytes += size;
+        *frames += packets(size);
+        (*segments)++;
+    }
+
+    int execHi = fgetc(fp), execLo = fgetc(fp);
+    fclose(fp);
+    if (execHi == EOF || execLo == EOF) {
+        fprintf(stderr, "gt1pack: '%s' is truncated\n", path);
+        return 0;
+    }
+    execAddr = (uint16_t)((execHi << 8) | execLo);
+
+    return 1;
+}
+
+// Page 0 must come first, (a <hi> of 0 anywhere else ends the file), then the execute page, then the rest
+static int saveGt1(const char *path, int *bytes, int *segments, int *frames) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "gt1pack: can't create '%s'\n", path);
+        return 0;
+    }
+
+    int order[257];
+    int numPages = 0;
+    order[numPages++] = 0;
+    order[numPages++] = execAddr >> 8;
+    for (int page = 1; page < 256; page++) {
+        if (page != (execAddr >> 8)) order[numPages++] = page;
+    }
+
+    *bytes = *segments = 0;
+    *frames = 1;
+    for (int p = 0; p < numPages; p++) {
+        int base = order[p] << 8;
+        for (int lo = 0; lo < 256; ) {
+            if (!loaded[base + lo]) {
+                lo++;
+                continue;
+            }
+            int start = lo;
+            while (lo < 256 && loaded[base + lo]) lo++;
+            int size = lo - start;
+            fputc(base >> 8, fp);
+            fputc(start, fp);
+            fputc(size & 0xFF, fp);
+            fwrite(&ram[base + start], 1, size, fp);
+            *bytes += size;
+            *frames += packets(size);
+            (*segments)++;
+        }
+    }
+    fputc(0, fp);
+    fputc(execAddr >> 8, fp);
+    fputc(execAddr & 0xFF, fp);
+
+    fclose(fp);
+    return 1;
+}
+
+static int isFree(int addr) {
+    return addr >= 0x0800 && addr < 0x8000 && (addr & 0xFF) >= 0xA0 && !loaded[addr] && !reserved[addr];
+}
+
+// Next run of free offscreen bytes of at least size bytes, starting the search at *from
+static int findFree(int *from, int size) {
+    for (int addr = *from; addr + size <= 0x8000; addr++) {
+        int run = 0;
+        while (run < size && isFree(addr + run) && ((addr + run) >> 8) == (addr >> 8)) run++;
+        if (run == size) {
+            *from = addr + size;
+            return addr;
+        }
+        addr += run;
+    }
+    return -1;
+}
+
+// Loader packets needed by the runs of loaded bytes in one page
+static int pagePackets(int page) {
+    int total = 0;
+    for (int lo = 0; lo < 256; ) {
+        int start = lo;
+        while (lo < 256 && loaded[(page << 8) + lo]) lo++;
+        total += packets(lo - start);
+        if (lo == start) lo++;
+    }
+    return total;
+}
+
+static void emit(int addr, int value) {
+    ram[addr] = (uint8_t)value;
+    loaded[addr] = 1;
+}
+
+int main(int argc, char *argv[]) {
+    int packAll = 0, tableWord = 0x08A8, arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-a") == 0) {
+            packAll = 1;
+        } else if (strcmp(argv[arg], "-u") == 0 && arg + 1 < argc) {
+            tableWord = (int)strtol(argv[++arg], NULL, 0);
+        } else if (strcmp(argv[arg], "-k") == 0 && arg + 1 < argc && numKeeps < MAX_KEEPS) {
+            char *colon;
+            keeps[numKeeps].addr = (uint16_t)strtol(argv[++arg], &colon, 0);
+            keeps[numKeeps++].size = (*colon == ':') ? (int)strtol(colon + 1, NULL, 0) : 1;
+        } else {
+            break;
+        }
+    }
+
+    if (argc - arg != 3) {
+        fprintf(stderr, "Usage: gt1pack [-a] [-u addr] [-k addr:size]... <sugarglider.gasm> <in.gt1> <out.gt1>\n");
+        return 1;
+    }
+
+    int bytesIn, segmentsIn, framesIn;
+    if (!loadGasm(argv[arg])) return 1;
+    if (!loadGt1(argv[arg + 1], &bytesIn, &segmentsIn, &framesIn)) return 1;
+
+    for (int i = 0; i < numKeeps; i++) memset(&reserved[keeps[i].addr], 1, keeps[i].size);
+    memset(&reserved[HITABLE], 1, HITABLE_SIZE);
+    reserved[tableWord] = reserved[tableWord + 1] = 1;
+
+    // pack every chunk in place, remembering the table entries
+    uint8_t entries[MAX_CHUNKS][3];
+    int numEntries = 0, groups = 0;
+    for (int c = 0; c < numChunks; c++) {
+        int addr = chunks[c].addr, size = chunks[c].size;
+        int g = (size - 1)/4, tail = size - g*4;
+
+        int packable = (g > 0 && g < 64);
+        for (int i = 0; i < size && packable; i++) {
+            if (!loaded[addr + i] || (i < g*4 && ram[addr + i] >= 64)) packable = 0;
+        }
+        memset(&reserved[addr], 1, size);
+        if (!packable) continue;
+
+        uint8_t tailBytes[4], unpacked[256];
+        int before = pagePackets(addr >> 8);
+        memcpy(unpacked, &ram[addr], size);
+        memcpy(tailBytes, &ram[addr + g*4], tail);
+        for (int i = 0; i < g; i++) {
+            const uint8_t *p = &ram[addr + i*4];
+            uint32_t v = p[0] | (p[1] << 6) | (p[2] << 12) | ((uint32_t)p[3] << 18);
+            ram[addr + i*3 + 0] = (uint8_t)(v & 0xFF);
+            ram[addr + i*3 + 1] = (uint8_t)((v >> 8) & 0xFF);
+            ram[addr + i*3 + 2] = (uint8_t)(v >> 16);
+        }
+        memcpy(&ram[addr + g*3], tailBytes, tail);
+        memset(&loaded[addr + g*3 + tail], 0, g);
+        if (!packAll && pagePackets(addr >> 8) >= before) {
+            memcpy(&ram[addr], unpacked, size);
+            memset(&loaded[addr], 1, size);
+            continue;
+        }
+
+        entries[numEntries][0] = (uint8_t)(addr & 0xFF);
+        entries[numEntries][1] = (uint8_t)(addr >> 8);
+        entries[numEntries++][2] = (uint8_t)(g | ((tail - 1) << 6));
+        groups += g;
+    }
+
+    // lay the table out in offscreen runs, each run ends in a link entry or the 0 terminator
+    int search = 0x0800, tableAddr = -1, prevLink = -1, e = 0;
+    while (e < numEntries) {
+        int run = findFree(&search, 6);
+        if (run < 0) {
+            fprintf(stderr, "gt1pack: no free offscreen bytes left for the unpack table\n");
+            return 1;
+        }
+        int end = run;
+        while (end < ((run | 0xFF) + 1) && isFree(end)) end++;
+
+        if (tableAddr < 0) tableAddr = run;
+        if (prevLink >= 0) {
+            emit(prevLink + 0, run & 0xFF);
+            emit(prevLink + 1, run >> 8);
+            emit(prevLink + 2, 0);
+        }
+
+        int addr = run;
+        while (e < numEntries && addr + 6 <= end) {
+            for (int i = 0; i < 3; i++) emit(addr + i, entries[e][i]);
+            addr += 3;
+            e++;
+        }
+        prevLink = addr;
+        for (int i = 0; i < 3; i++) loaded[addr + i] = reserved[addr + i] = 1;
+        search = end;
+    }
+    if (numEntries) {
+        emit(prevLink + 0, 0);
+        emit(prevLink + 1, 0);
+        emit(prevLink + 2, 0);
+        emit(tableWord + 0, tableAddr & 0xFF);
+        emit(tableWord + 1, tableAddr >> 8);
+    }
+
+    int bytesOut, segmentsOut, framesOut;
+    if (!saveGt1(argv[arg + 2], &bytesOut, &segmentsOut, &framesOut)) return 1;
+
+    printf("%d of %d chunks packed, %d groups, (SYS_Unpack_56 calls at startup)", numEntries, numChunks, groups);
+    if (numEntries) printf(", table at 0x%04x", tableAddr);
+    printf("\n");
+    printf("before  %3d segments, %5d bytes, %4d frames, %.2f s\n", segmentsIn, bytesIn, framesIn, framesIn / FRAME_RATE);
+    printf("after   %3d segments, %5d bytes, %4d frames, %.2f s\n", segmentsOut, bytesOut, framesOut, framesOut / FRAME_RATE);
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+// memheat - per byte read/write heatmap of the 32K Gigatron address space
+//
+// Build: cc -O2 -o memheat memheat.c
+// Usage: memheat <sugarglider.gasm> <sugarglider.gt1> <trace.txt|-> [heatmap.ppm]
+//
+// The trace is the memory access log of a recorded Sugarglider session, one
+// access per line, "R 0030" or "W 00e8", (hex address, lines starting with '#'
+// are ignored, vCPU instruction fetches count as reads), or '-' to read it from
+// a pipe. No emulator writes it as is, it comes from two lines added to the
+// RAM access of the reference emulator's cpuCycle(), (Docs/gtemu.c in the
+// gigatron-rom repository):
+//
+//     case 1: if (!W) { B = RAM[addr&0x7fff]; printf("R %04x\n", addr&0x7fff); } break;
+//     ...
+//     if (W) { RAM[addr&0x7fff] = B; printf("W %04x\n", addr&0x7fff); }
+//
+// Those are native accesses, so the vCPU interpreter's own zero page traffic,
+// (vPC, vAC, vLR and the sys registers), lands in the system region. Load the
+// .gt1 and play with the emulator's output piped in, a second of play is
+// millions of lines so pipe it rather than keep it. Every access bumps a
+// packed counter, (reads in the low 16 bits, writes in the high 16 bits, both
+// saturating), and the result is rendered as a 256x128 image, one pixel per byte
+// and one row per 256 byte page.
+//
+// The .gt1 marks which bytes are part of the loaded image and the .gasm is used
+// to label the regions that matter for placement decisions:
+// zero page globals, the 0xe8..0xec expression temporaries, arrays, blit stripe
+// chunks and the screen. A per region summary and the list of loaded but never
+// touched ranges are printed to stdout.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define RAM_SIZE    0x8000
+#define MAX_REGIONS 256
+#define MIN_UNUSED  8       // smallest untouched run worth reporting
+
+#define READS(c)    ((c) & 0xFFFF)
+#define WRITES(c)   ((c) >> 16)
+
+typedef struct {
+    char name[48];
+    uint16_t start;
+    uint16_t size;
+} region_t;
+
+static uint32_t counters[RAM_SIZE];
+static uint8_t  owned[RAM_SIZE];    // byte is loaded by the .gt1 or labelled by the .gasm
+static region_t regions[MAX_REGIONS];
+static int numRegions = 0;
+
+static void addRegion(const char *name, int start, int size) {
+    if (numRegions == MAX_REGIONS || start < 0 || start >= RAM_SIZE || size <= 0) return;
+    if (start + size > RAM_SIZE) size = RAM_SIZE - start;
+
+    region_t *r = &regions[numRegions++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->start = (uint16_t)start;
+    r->size = (uint16_t)size;
+    for (int i = start; i < start + size; i++) owned[i] = 1;
+}
+
+static void count(int write, int addr) {
+    uint32_t c = counters[addr & (RAM_SIZE - 1)];
+    if (write) {
+        if (WRITES(c) != 0xFFFF) c += 0x10000;
+    } else {
+        if (READS(c) != 0xFFFF) c += 1;
+    }
+    counters[addr & (RAM_SIZE - 1)] = c;
+}
+
+// Number of operands on a DB/DW line, strings count their characters
+static int countOperands(const char *p) {
+    int n = 0;
+    while (*p && *p != ';') {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p || *p == ';') break;
+        if (*p == '\'') {
+            const char *q = strchr(p + 1, '\'');
+            if (!q) break;
+            n += (int)(q - p - 1);
+            p = q + 1;
+        } else {
+            n++;
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+    }
+    return n;
+}
+
+static int loadGasm(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "memheat: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[4096], section[64] = "";
+    char lastLabel[64] = "";
+    int lastAddr = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == ';') {
+            if (line[1] == ' ') sscanf(line + 2, "%63[^\r\n]", section);
+            continue;
+        }
+
+        // everything past the runtime banner is code, which the GT1 segments cover
+        if (strncmp(section, "Code", 4) == 0) break;
+
+        char label[64], op[16], arg[64];
+        if (sscanf(line, "%63s %15s %63s", label, op, arg) != 3) continue;
+
+        if (strcmp(op, "EQU") == 0) {
+            int addr = (int)strtol(arg, NULL, 0);
+            if (strcmp(section, "Global Variables") == 0 || strcmp(section, "Local Variables") == 0) {
+                addRegion(label, addr, 2);
+            } else {
+                snprintf(lastLabel, sizeof(lastLabel), "%s", label);
+                lastAddr = (arg[0] == '0') ? addr : -1;
+            }
+        } else if ((strcmp(op, "DB") == 0 || strcmp(op, "DW") == 0) && strcmp(label, lastLabel) == 0 && lastAddr >= 0) {
+            const char *p = strstr(line, op) + 2;
+            int n = countOperands(p);
+            addRegion(label, lastAddr, (op[1] == 'W') ? n*2 : n);
+            lastAddr = -1;
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int loadGt1(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "memheat: can't open '%s'\n", path);
+        return 0;
+    }
+
+    // segments are <hi> <lo> <size> <data...>, a size of 0 means 256, a <hi> of 0 past the first segment ends the file
+    int first = 1, hi;
+    while ((hi = fgetc(fp)) != EOF) {
+        if (hi == 0 && !first) break;
+        int lo = fgetc(fp), size = fgetc(fp);
+        if (lo == EOF || size == EOF) break;
+        if (size == 0) size = 256;
+        for (int i = 0; i < size; i++) {
+            if (fgetc(fp) == EOF) break;
+            owned[(((hi << 8) | lo) + i) & (RAM_SIZE - 1)] = 1;
+        }
+        first = 0;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int loadTrace(const char *path, long *total) {
+    FILE *fp = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "memheat: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[128];
+    *total = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char kind;
+        unsigned int addr;
+        if (line[0] == '#' || sscanf(line, " %c %x", &kind, &addr) != 2) continue;
+        if (kind != 'R' && kind != 'W') continue;
+        count(kind == 'W', (int)addr);
+        (*total)++;
+    }
+
+    if (fp != stdin) fclose(fp);
+    return 1;
+}
+
+static void summarise(const char *name, int start, int size) {
+    unsigned long reads = 0, writes = 0;
+    int untouched = 0;
+    for (int i = start; i < start + size && i < RAM_SIZE; i++) {
+        reads += READS(counters[i]);
+        writes += WRITES(counters[i]);
+        if (counters[i] == 0) untouched++;
+    }
+    printf("  %-32s 0x%04x %5d  %9lu %9lu %6d\n", name, start, size, reads, writes, untouched);
+}
+
+// Heat is log scaled so a handful of accesses still shows up next to the hot zero page
+static uint8_t heat(unsigned int n) {
+    int bits = 0;
+    while (n) {
+        bits++;
+        n >>= 1;
+    }
+    return (uint8_t)((bits >= 16) ? 255 : 64 + bits*12);
+}
+
+static int writeImage(const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "memheat: can't create '%s'\n", path);
+        return 0;
+    }
+
+    // reads are green, writes are red, untouched bytes owned by a region are dark blue
+    fprintf(fp, "P6\n256 128\n255\n");
+    for (int addr = 0; addr < RAM_SIZE; addr++) {
+        uint32_t c = counters[addr];
+        uint8_t rgb[3] = {0, 0, 0};
+        if (c) {
+            rgb[0] = WRITES(c) ? heat(WRITES(c)) : 0;
+            rgb[1] = READS(c) ? heat(READS(c)) : 0;
+        } else if (owned[addr]) {
+            rgb[2] = 96;
+        }
+        fwrite(rgb, 1, 3, fp);
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: memheat <sugarglider.gasm> <sugarglider.gt1> <trace.txt|-> [heatmap.ppm]\n");
+        return 1;
+    }
+
+    if (!loadGasm(argv[1])) return 1;
+    if (!loadGt1(argv[2])) return 1;
+
+    long total;
+    if (!loadTrace(argv[3], &total)) return 1;
+
+    printf("%ld accesses\n\n", total);
+    printf("  %-32s %-6s %5s  %9s %9s %6s\n", "region", "addr", "size", "reads", "writes", "unused");
+    summarise("zero page globals", 0x0030, 0x0050);
+    summarise("expression temporaries", 0x00e8, 0x0005);
+    summarise("screen", 0x0800, 0x7800);
+    for (int i = 0; i < numRegions; i++) {
+        summarise(regions[i].name, regions[i].start, regions[i].size);
+    }
+
+    // off screen bytes that are part of the image but never touched, (reclaimable)
+    printf("\nuntouched runs of %d bytes or more, (outside of the visible 160 bytes of each line):\n", MIN_UNUSED);
+    int runStart = -1;
+    for (int addr = 0x0030; addr <= RAM_SIZE; addr++) {
+        int visible = (addr >= 0x0800 && addr < RAM_SIZE && (addr & 0xFF) < 160);
+        int idle = (addr < RAM_SIZE && !visible && owned[addr] && counters[addr] == 0);
+        if (idle && runStart < 0) runStart = addr;
+        if (!idle && runStart >= 0) {
+            if (addr - runStart >= MIN_UNUSED) printf("  0x%04x-0x%04x %5d\n", runStart, addr - 1, addr - runStart);
+            runStart = -1;
+        }
+    }
+
+    if (argc > 4 && !writeImage(argv[4])) return 1;
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+// memplan - free RAM map and bump allocator for placing new tables and pools
+//
+// Build: cc -O2 -o memplan memplan.c
+// Usage: memplan <sugarglider.gasm> <sugarglider.gt1> [reserve.txt]
+//
+// The .gt1 marks every byte the Loader writes and the .gasm labels what those
+// bytes are, (arrays, blit stripes, blit lookup tables, strings and the runtime
+// work areas, everything else loaded counts as code). What is left of the 32K
+// is user RAM below the screen, (0x0200..0x07ff), and the 96 off screen bytes
+// at the end of every screen line, which is where the compiler puts everything
+// itself, (arrays and blit stripes as _arraysStart_ and _blitStripeChunks_ ask,
+// searching down from 0x7fff).
+//
+// The reserve file lists what still has to go in, one per line, "name size" for
+// a table, "name count*size" for a pool of count slots, an optional third field
+// aligns the start, ('#' starts a comment). Reservations are bump allocated in
+// file order, each one at the top of what is used of the highest free run that
+// still has room for it, (searching down from the top of RAM like the compiler
+// does). No reservation crosses a page, so every one of them can be indexed
+// with a byte. The addresses come out as a 'memplan begin/end block to paste
+// into the source, a const and an alloc per reservation, the alloc takes the
+// range out of the compiler's free RAM so nothing it places later lands on the
+// table, (a bare const reserves nothing). The block follows a per category
+// usage summary and the peak, (used plus reserved, out of the RAM that isn't
+// system or visible screen), so a table that won't fit shows up before the
+// compile that would fail. The hiscore table is never loaded, so it is marked
+// reserved here as the source's alloc does.
+//
+// Like the other tools this is a single file build on purpose, the .gt1 and
+// .gasm readers are repeated rather than shared, keep them in step with the
+// copies in the other tools.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define RAM_SIZE        0x8000
+#define USER_START      0x0200
+#define SCREEN_START    0x0800
+#define SCREEN_WIDTH    160
+#define MAX_RESERVES    64
+#define MAX_RUNS        256
+#define MAX_BUFFERS     8
+#define HITABLE         0x08A0  // hitable in sugarglider.gbas, the magic word and 3 scores
+#define HITABLE_SIZE    8
+
+enum {FREE = 0, SYSTEM, SCREEN, CODE, ARRAYS, BLITS, LUTS, STRINGS, BUFFERS, RESERVED, NUM_KINDS};
+
+static const char *kindNames[NUM_KINDS] = {
+    "free", "system", "screen", "code", "arrays", "blit stripes", "blit luts", "strings", "work areas", "reserved"
+};
+
+typedef struct {
+    char name[64];
+    int size;
+    int align;
+    int addr;
+} reserve_t;
+
+typedef struct {
+    uint16_t start;
+    uint16_t size;
+    uint16_t used;
+} run_t;
+
+typedef struct {
+    char name[64];
+    uint16_t start;
+    uint16_t size;
+} buffer_t;
+
+static uint8_t   kind[RAM_SIZE];
+static uint8_t   loaded[RAM_SIZE];
+static reserve_t reserves[MAX_RESERVES];
+static run_t     runs[MAX_RUNS];
+static buffer_t  buffers[MAX_BUFFERS];
+static int numReserves = 0, numRuns = 0, numBuffers = 0;
+
+static void mark(int start, int size, int k) {
+    for (int i = start; i < start + size && i < RAM_SIZE; i++) {
+        if (i >= 0) kind[i] = (uint8_t)k;
+    }
+}
+
+// Number of operands on a DB/DW line, strings count their characters
+static int countOperands(const char *p) {
+    int n = 0;
+    while (*p && *p != ';') {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p || *p == ';') break;
+        if (*p == '\'') {
+            const char *q = strchr(p + 1, '\'');
+            if (!q) break;
+            n += (int)(q - p - 1);
+            p = q + 1;
+        } else {
+            n++;
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+    }
+    return n;
+}
+
+static int sectionKind(const char *section) {
+    if (strcmp(section, "Arrays") == 0) return ARRAYS;
+    if (strcmp(section, "Define Blits") == 0) return BLITS;
+    if (strcmp(section, "Lookup Tables") == 0) return LUTS;
+    if (strstr(section, "Strings")) return STRINGS;
+    return CODE;
+}
+
+static int loadGt1(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "memplan: can't open '%s'\n", path);
+        return 0;
+    }
+
+    // segments are <hi> <lo> <size> <data...>, a size of 0 means 256, a <hi> of 0 past the first segment ends the file
+    int first = 1, hi;
+    while ((hi = fgetc(fp)) != EOF) {
+        if (hi == 0 && !first) break;
+        int lo = fgetc(fp), size = fgetc(fp);
+        if (lo == EOF || size == EOF) break;
+        if (size == 0) size = 256;
+        for (int i = 0; i < size; i++) {
+            if (fgetc(fp) == EOF) break;
+            loaded[(((hi << 8) | lo) + i) & (RAM_SIZE - 1)] = 1;
+        }
+        first = 0;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int loadGasm(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "memplan: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[4096], section[64] = "";
+    char lastLabel[64] = "";
+    int lastAddr = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == ';') {
+            if (line[1] == ' ') sscanf(line + 2, "%63[^\r\n]", section);
+            continue;
+        }
+
+        // everything past the runtime banner is code, which the GT1 segments cover
+        if (strncmp(section, "Code", 4) == 0) break;
+
+        char label[64], op[16], arg[64];
+        if (sscanf(line, "%63s %15s %63s", label, op, arg) != 3) continue;
+
+        if (strcmp(op, "EQU") == 0) {
+            int addr = (int)strtol(arg, NULL, 0);
+            if (strcmp(section, "Internal Buffers") == 0 && addr >= SCREEN_START) {
+                // work areas run to the end of their line's off screen bytes, they are marked once everything else is
+                if (numBuffers < MAX_BUFFERS) {
+                    buffer_t *b = &buffers[numBuffers++];
+                    snprintf(b->name, sizeof(b->name), "%s", label);
+                    b->start = (uint16_t)addr;
+                    b->size = (uint16_t)(0x100 - (addr & 0xFF));
+                }
+            } else {
+                snprintf(lastLabel, sizeof(lastLabel), "%s", label);
+                lastAddr = (arg[0] == '0') ? addr : -1;
+            }
+        } else if ((strcmp(op, "DB") == 0 || strcmp(op, "DW") == 0) && strcmp(label, lastLabel) == 0 && lastAddr >= 0) {
+            const char *p = strstr(line, op) + 2;
+            int n = countOperands(p);
+            mark(lastAddr, (op[1] == 'W') ? n*2 : n, sectionKind(section));
+            lastAddr = -1;
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int loadReserves(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "memplan: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[256];
+    int lineNum = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineNum++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+
+        char name[48], size[32];
+        int align = 1;
+        int n = sscanf(line, "%47s %31s %d", name, size, &align);
+        if (n <= 0) continue;
+        if (n < 2 || align < 1 || numReserves == MAX_RESERVES) {
+            fprintf(stderr, "memplan: bad reservation on line %d of '%s'\n", lineNum, path);
+            fclose(fp);
+            return 0;
+        }
+
+        // "count*size" is a pool, "size" a single table
+        int count = 1, bytes;
+        char *star = strchr(size, '*');
+        if (star) {
+            *star = 0;
+            count = (int)strtol(size, NULL, 0);
+            bytes = (int)strtol(star + 1, NULL, 0);
+        } else {
+            bytes = (int)strtol(size, NULL, 0);
+        }
+
+        reserve_t *r = &reserves[numReserves++];
+        snprintf(r->name, sizeof(r->name), "%s", name);
+        r->size = count*bytes;
+        r->align = align;
+        r->addr = -1;
+        if (r->size <= 0 || r->size > 0x100) {
+            fprintf(stderr, "memplan: '%s' is %d bytes, a reservation has to fit in a page\n", r->name, r->size);
+            fclose(fp);
+            return 0;
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+// Free runs never cross a page, highest first, which is the order the compiler fills them
+static void findRuns(void) {
+    int runEnd = -1;
+    for (int addr = RAM_SIZE - 1; addr >= USER_START - 1; addr--) {
+        int free = (addr >= USER_START && kind[addr] == FREE);
+        if (free && runEnd < 0) runEnd = addr;
+        if (runEnd < 0) continue;
+
+        // a run ends below a used byte or at the start of its page
+        if (!free || (addr & 0xFF) == 0) {
+            int start = free ? addr : addr + 1;
+            if (numRuns < MAX_RUNS) {
+                runs[numRuns].start = (uint16_t)start;
+                runs[numRuns].size = (uint16_t)(runEnd - start + 1);
+                runs[numRuns].used = 0;
+                numRuns++;
+            }
+            runEnd = -1;
+        }
+    }
+}
+
+// Each run is a bump allocator, a request goes in the highest run with enough left at its top
+static int allocate(void) {
+    int ok = 1;
+    for (int i = 0; i < numReserves; i++) {
+        reserve_t *r = &reserves[i];
+        for (int j = 0; j < numRuns; j++) {
+            int addr = runs[j].start + runs[j].used;
+            int pad = (r->align - addr % r->align) % r->align;
+            if (runs[j].used + pad + r->size > runs[j].size) continue;
+
+            r->addr = addr + pad;
+            runs[j].used = (uint16_t)(runs[j].used + pad + r->size);
+            mark(r->addr, r->size, RESERVED);
+            break;
+        }
+
+        if (r->addr < 0) {
+            fprintf(stderr, "memplan: no room left for '%s', %d bytes\n", r->name, r->size);
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: memplan <sugarglider.gasm> <sugarglider.gt1> [reserve.txt]\n");
+        return 1;
+    }
+
+    mark(0x0000, USER_START, SYSTEM);
+    for (int addr = SCREEN_START; addr < RAM_SIZE; addr++) {
+        if ((addr & 0xFF) < SCREEN_WIDTH) kind[addr] = SCREEN;
+    }
+
+    if (!loadGt1(argv[2])) return 1;
+    if (!loadGasm(argv[1])) return 1;
+    for (int addr = USER_START; addr < RAM_SIZE; addr++) {
+        if (loaded[addr] && kind[addr] == FREE) kind[addr] = CODE;
+    }
+
+    // a freed work area, (free STRINGWORKAREA), gets handed out again, so only what nothing else claims is counted
+    for (int i = 0; i < numBuffers; i++) {
+        int shared = 0;
+        for (int addr = buffers[i].start; addr < buffers[i].start + buffers[i].size; addr++) {
+            if (kind[addr] == FREE) kind[addr] = BUFFERS;
+            else shared++;
+        }
+        if (shared) printf("%s 0x%04x shares %d of its %d bytes, (only safe while its runtime is unused)\n", buffers[i].name, buffers[i].start, shared, buffers[i].size);
+    }
+
+    mark(HITABLE, HITABLE_SIZE, RESERVED);
+
+    findRuns();
+    int ok = 1;
+    if (argc > 3) {
+        if (!loadReserves(argv[3])) return 1;
+        ok = allocate();
+    }
+
+    int totals[NUM_KINDS] = {0};
+    for (int addr = 0; addr < RAM_SIZE; addr++) totals[kind[addr]]++;
+
+    int user = RAM_SIZE - totals[SYSTEM] - totals[SCREEN];
+    int peak = user - totals[FREE];
+    printf("  %-14s %6s\n", "category", "bytes");
+    for (int k = CODE; k < NUM_KINDS; k++) printf("  %-14s %6d\n", kindNames[k], totals[k]);
+    printf("  %-14s %6d\n", kindNames[FREE], totals[FREE]);
+    printf("\npeak %d of %d bytes, (%d%%), outside of the system pages and the visible screen\n", peak, user, peak*100/user);
+
+    // largest first, these are the runs a new table has to fit in
+    int largest = 0;
+    for (int i = 0; i < numRuns; i++) {
+        if (runs[i].size - runs[i].used > largest) largest = runs[i].size - runs[i].used;
+    }
+    printf("largest free run %d bytes\n", largest);
+
+    if (numReserves) {
+        printf("\n'memplan begin\n");
+        for (int i = 0; i < numReserves; i++) {
+            if (reserves[i].addr < 0) continue;
+            printf("const %s = &h%04X '%d bytes\n", reserves[i].name, reserves[i].addr, reserves[i].size);
+            printf("alloc %s, %d\n", reserves[i].name, reserves[i].size);
+        }
+        printf("'memplan end\n");
+    }
+
+    return ok ? 0 : 1;
+}
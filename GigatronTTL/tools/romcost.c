@@ -0,0 +1,320 @@
+// romcost - static per ROM cost matrix of the gtBASIC runtime's %SUB routines
+//
+// Build: cc -O2 -o romcost romcost.c
+// Usage: romcost [-c costs.txt] [-m module] <runtime dir>
+//
+// The runtime ships one file per module and ROM, (math.i, math_ROMv5a.i,
+// math_ROMvX0.i...), and a build for a ROM uses the newest variant that isn't
+// newer than the ROM, so every column is the set of files that build would
+// assemble. Each %SUB is reported as "instructions/loop", the vCPU
+// instructions between %SUB and %ENDS and the size of its largest loop body,
+// (a branch back to a label inside the routine), which is what repeats per
+// pixel, row or digit. Macro uses count as one instruction.
+//
+// This is a static count, not an emulator run, so it ranks routines and ROMs
+// but doesn't replace profiling. With -c every instruction is weighted by a
+// cycle table, lines of "<rom|*> <opcode> <cycles>", (e.g. "ROMv5a LDW 20" or
+// "* RET 16"), and "SYS n" costs its n cycle budget; opcodes missing from the
+// table are counted and listed on stderr so the table can be completed.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+
+#define NUM_ROMS     5
+#define MAX_MODULES  64
+#define MAX_ROUTINES 1024
+#define MAX_LINES    512
+#define MAX_COSTS    1024
+#define MAX_MISSING  128
+
+static const char *romNames[NUM_ROMS] = {"ROMv1", "ROMv2", "ROMv3", "ROMv5a", "ROMvX0"};
+
+typedef struct {
+    char name[48];
+    int variant[NUM_ROMS];              // which ROMs have their own file
+} module_t;
+
+typedef struct {
+    char module[48];
+    char name[48];
+    int rom;                            // the file's ROM, not the build's
+    long insns, loop;
+    long cycles, loopCycles;
+} routine_t;
+
+typedef struct {
+    int rom;                            // -1 for every ROM
+    char opcode[16];
+    int cycles;
+} cost_t;
+
+static module_t modules[MAX_MODULES];
+static int numModules = 0;
+static routine_t routines[MAX_ROUTINES];
+static int numRoutines = 0;
+static cost_t costs[MAX_COSTS];
+static int numCosts = 0;
+static char missing[MAX_MISSING][16];
+static int numMissing = 0;
+
+static int romIndex(const char *name) {
+    for (int i = 0; i < NUM_ROMS; i++) {
+        if (strcmp(name, romNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int loadCosts(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "romcost: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char line[256], rom[16], opcode[16];
+    int cycles;
+    while (fgets(line, sizeof(line), fp) && numCosts < MAX_COSTS) {
+        if (line[0] == '#' || sscanf(line, "%15s %15s %d", rom, opcode, &cycles) != 3) continue;
+        costs[numCosts].rom = (strcmp(rom, "*") == 0) ? -1 : romIndex(rom);
+        snprintf(costs[numCosts].opcode, sizeof(costs[numCosts].opcode), "%s", opcode);
+        costs[numCosts++].cycles = cycles;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+// Cycles of one instruction, a ROM specific entry wins over a "*" one, -1 if unknown
+static int cost(int rom, const char *opcode, const char *operand) {
+    if (strcmp(opcode, "SYS") == 0) return (int)strtol(operand, NULL, 0);
+
+    int found = -1;
+    for (int i = 0; i < numCosts; i++) {
+        if (strcmp(costs[i].opcode, opcode) != 0) continue;
+        if (costs[i].rom == rom) return costs[i].cycles;
+        if (costs[i].rom < 0) found = costs[i].cycles;
+    }
+    if (found < 0 && numCosts) {
+        int known = 0;
+        for (int i = 0; i < numMissing && !known; i++) known = (strcmp(missing[i], opcode) == 0);
+        if (!known && numMissing < MAX_MISSING) snprintf(missing[numMissing++], sizeof(missing[0]), "%.15s", opcode);
+    }
+    return found;
+}
+
+// "math_ROMv5a.i" is module "math" for ROMv5a, "math.i" is module "math" for ROMv1
+static int splitName(const char *file, char *module, int *rom) {
+    size_t len = strlen(file);
+    if (len < 3 || strcmp(file + len - 2, ".i") != 0) return 0;
+
+    char base[64];
+    snprintf(base, sizeof(base), "%.*s", (int)(len - 2), file);
+    *rom = 0;
+    char *suffix = strstr(base, "_ROM");
+    if (suffix) {
+        *rom = romIndex(suffix + 1);
+        if (*rom < 0) return 0;
+        *suffix = 0;
+    }
+    snprintf(module, 48, "%.47s", base);
+    return 1;
+}
+
+static module_t *findModule(const char *name) {
+    for (int i = 0; i < numModules; i++) {
+        if (strcmp(modules[i].name, name) == 0) return &modules[i];
+    }
+    if (numModules == MAX_MODULES) return NULL;
+    module_t *m = &modules[numModules++];
+    memset(m, 0, sizeof(*m));
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    return m;
+}
+
+static void addRoutine(const char *module, const char *name, int rom, char labels[][48], int *labelLine, int numLabels,
+                       char opcodes[][16], char operands[][64], int numInsns) {
+    if (numRoutines == MAX_ROUTINES) return;
+
+    routine_t *r = &routines[numRoutines++];
+    snprintf(r->module, sizeof(r->module), "%s", module);
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->rom = rom;
+    r->insns = numInsns;
+    r->loop = r->cycles = r->loopCycles = 0;
+
+    long *cycles = calloc(numInsns + 1, sizeof(long));
+    for (int i = 0; i < numInsns; i++) {
+        int c = cost(rom, opcodes[i], operands[i]);
+        cycles[i + 1] = cycles[i] + ((c > 0) ? c : 0);
+    }
+    r->cycles = cycles[numInsns];
+
+    // a branch to a label at or before itself closes a loop, CALLI to a label is a call
+    for (int i = 0; i < numInsns; i++) {
+        if (strcmp(opcodes[i], "CALLI") == 0 || !operands[i][0]) continue;
+        for (int l = 0; l < numLabels; l++) {
+            if (labelLine[l] > i || strstr(operands[i], labels[l]) == NULL) continue;
+            size_t n = strlen(labels[l]);
+            const char *hit = strstr(operands[i], labels[l]);
+            if ((hit != operands[i] && hit[-1] != ',' && hit[-1] != ' ') || (hit[n] && hit[n] != ',' && hit[n] != ' ')) continue;
+            if (i - labelLine[l] + 1 > r->loop) {
+                r->loop = i - labelLine[l] + 1;
+                r->loopCycles = cycles[i + 1] - cycles[labelLine[l]];
+            }
+        }
+    }
+    free(cycles);
+}
+
+static int loadFile(const char *dir, const char *file) {
+    char module[48], path[512];
+    int rom;
+    if (!splitName(file, module, &rom)) return 1;
+
+    module_t *m = findModule(module);
+    if (!m) return 1;
+    m->variant[rom] = 1;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "romcost: can't open '%s'\n", path);
+        return 0;
+    }
+
+    static char labels[MAX_LINES][48], opcodes[MAX_LINES][16], operands[MAX_LINES][64];
+    static int labelLine[MAX_LINES];
+    char line[512], name[48] = "";
+    int inSub = 0, numLabels = 0, numInsns = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char *semi = strchr(line, ';');
+        if (semi) *semi = 0;
+
+        if (strncmp(line, "%SUB", 4) == 0) {
+            inSub = (sscanf(line + 4, "%47s", name) == 1);
+            numLabels = numInsns = 0;
+            continue;
+        }
+        if (strncmp(line, "%ENDS", 5) == 0) {
+            if (inSub) addRoutine(module, name, rom, labels, labelLine, numLabels, opcodes, operands, numInsns);
+            inSub = 0;
+            continue;
+        }
+        if (!inSub || line[0] == '%') continue;
+
+        // an optional label in column 0, then the opcode and its operands
+        char *p = line;
+        if (!isspace((unsigned char)*p) && *p) {
+            char label[48];
+            if (sscanf(p, "%47s", label) == 1 && numLabels < MAX_LINES) {
+                snprintf(labels[numLabels], sizeof(labels[0]), "%s", label);
+                labelLine[numLabels++] = numInsns;
+            }
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+
+        char opcode[16];
+        if (sscanf(p, "%15s", opcode) != 1 || numInsns == MAX_LINES) continue;
+        if (islower((unsigned char)opcode[0])) continue;    // emulator directives, (e.g. gprintf)
+        p = strstr(p, opcode) + strlen(opcode);
+        while (isspace((unsigned char)*p)) p++;
+        snprintf(opcodes[numInsns], sizeof(opcodes[0]), "%s", opcode);
+        snprintf(operands[numInsns], sizeof(operands[0]), "%s", p);
+        char *end = operands[numInsns] + strlen(operands[numInsns]);
+        while (end > operands[numInsns] && isspace((unsigned char)end[-1])) *--end = 0;
+        numInsns++;
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static const routine_t *findRoutine(const char *module, const char *name, int rom) {
+    for (int i = 0; i < numRoutines; i++) {
+        if (routines[i].rom == rom && strcmp(routines[i].module, module) == 0 && strcmp(routines[i].name, name) == 0) return &routines[i];
+    }
+    return NULL;
+}
+
+// The file a build for rom assembles for a module, the newest variant not newer than rom
+static int buildVariant(const module_t *m, int rom) {
+    for (int v = rom; v >= 0; v--) {
+        if (m->variant[v]) return v;
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    const char *only = NULL;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc) {
+            if (!loadCosts(argv[++arg])) return 1;
+        } else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) {
+            only = argv[++arg];
+        } else {
+            break;
+        }
+    }
+
+    if (arg >= argc) {
+        fprintf(stderr, "Usage: romcost [-c costs.txt] [-m module] <runtime dir>\n");
+        return 1;
+    }
+
+    DIR *dir = opendir(argv[arg]);
+    if (!dir) {
+        fprintf(stderr, "romcost: can't open '%s'\n", argv[arg]);
+        return 1;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!loadFile(argv[arg], entry->d_name)) {
+            closedir(dir);
+            return 1;
+        }
+    }
+    closedir(dir);
+
+    printf("%s per build, (- = not in that build)\n\n", numCosts ? "cycles/loop cycles" : "instructions/loop instructions");
+    printf("%-36s", "routine");
+    for (int r = 0; r < NUM_ROMS; r++) printf(" %11s", romNames[r]);
+    printf("\n");
+
+    for (int i = 0; i < numRoutines; i++) {
+        const routine_t *ri = &routines[i];
+        if (only && strcmp(ri->module, only) != 0) continue;
+
+        // one row per routine name, printed when its first variant comes up
+        int first = 1;
+        for (int j = 0; j < i && first; j++) {
+            first = !(strcmp(routines[j].module, ri->module) == 0 && strcmp(routines[j].name, ri->name) == 0);
+        }
+        if (!first) continue;
+
+        const module_t *m = findModule(ri->module);
+        char row[96];
+        snprintf(row, sizeof(row), "%.47s:%.47s", ri->module, ri->name);
+        printf("%-36s", row);
+        for (int r = 0; r < NUM_ROMS; r++) {
+            int v = buildVariant(m, r);
+            const routine_t *b = (v >= 0) ? findRoutine(ri->module, ri->name, v) : NULL;
+            char cell[32] = "-";
+            if (b) snprintf(cell, sizeof(cell), "%ld/%ld", numCosts ? b->cycles : b->insns, numCosts ? b->loopCycles : b->loop);
+            printf(" %11s", cell);
+        }
+        printf("\n");
+    }
+
+    if (numMissing) {
+        fprintf(stderr, "\nopcodes missing from the cost table, (counted as 0):");
+        for (int i = 0; i < numMissing; i++) fprintf(stderr, " %s", missing[i]);
+        fprintf(stderr, "\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+// sprcost - byte and SYS cycle comparison of Sprite6 blits against vX0 pattern sprites
+//
+// Build: cc -O2 -o sprcost sprcost.c
+// Usage: sprcost [-c] <frame0.tga> [frame1.tga]...
+//
+// All frames are one animated object, (e.g. coin0.tga to coin3.tga), drawn the
+// way the game draws it today, as a blit: ceil(w/6) Sprite6 stripes of 6*h bytes
+// plus a terminator each, a stripe LUT per frame and a _blitsLut_ entry. The
+// alternative is one SYS_DrawSprite_vX_140 sprite slot, (pixel buffer, saved
+// background and 4 bytes of position/height/LUT), animated by copying one of
+// the frames' patterns into it with SYS_SpritePattern_vX_134.
+//
+// -c crops the patterns to the bounding box of the non zero pixels of all the
+// frames, blits can't do that as they erase their old position with the blank
+// border columns.
+//
+// Cycles are SYS budget bounds, (calls * the budget in the SYS name), assuming
+// each SYS is re-entered once per row; the vCPU setup around them isn't counted,
+// so profile in the emulator before trusting the difference.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FRAMES   16
+#define MAX_SIZE     256
+#define STRIPE_WIDTH 6
+
+#define SPRITE6_CYCLES    64
+#define DRAWSPRITE_CYCLES 140
+#define RESTORE_CYCLES    124
+#define PATTERN_CYCLES    134
+
+typedef struct {
+    int w, h;
+    uint8_t pixels[MAX_SIZE*MAX_SIZE];
+} image_t;
+
+static image_t frames[MAX_FRAMES];
+
+// Uncompressed 24 bit TGA, converted to Gigatron RRGGBB colours
+static int loadTga(const char *path, image_t *img) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "sprcost: can't open '%s'\n", path);
+        return 0;
+    }
+
+    uint8_t header[18];
+    if (fread(header, 1, 18, fp) != 18 || header[2] != 2 || header[16] != 24) {
+        fprintf(stderr, "sprcost: '%s' isn't an uncompressed 24 bit TGA\n", path);
+        fclose(fp);
+        return 0;
+    }
+
+    img->w = header[12] | (header[13] << 8);
+    img->h = header[14] | (header[15] << 8);
+    if (img->w > MAX_SIZE || img->h > MAX_SIZE) {
+        fprintf(stderr, "sprcost: '%s' is too big\n", path);
+        fclose(fp);
+        return 0;
+    }
+
+    fseek(fp, header[0], SEEK_CUR);
+    int topDown = header[17] & 0x20;
+    for (int y = 0; y < img->h; y++) {
+        int row = topDown ? y : img->h - 1 - y;
+        for (int x = 0; x < img->w; x++) {
+            uint8_t bgr[3];
+            if (fread(bgr, 1, 3, fp) != 3) {
+                fprintf(stderr, "sprcost: '%s' is truncated\n", path);
+                fclose(fp);
+                return 0;
+            }
+            img->pixels[row*img->w + x] = (uint8_t)((bgr[2] >> 6) | ((bgr[1] >> 6) << 2) | ((bgr[0] >> 6) << 4));
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    int crop = 0, arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-c") == 0) {
+        crop = 1;
+        arg++;
+    }
+
+    int numFrames = argc - arg;
+    if (numFrames < 1 || numFrames > MAX_FRAMES) {
+        fprintf(stderr, "Usage: sprcost [-c] <frame0.tga> [frame1.tga]...\n");
+        return 1;
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        if (!loadTga(argv[arg + i], &frames[i])) return 1;
+        if (frames[i].w != frames[0].w || frames[i].h != frames[0].h) {
+            fprintf(stderr, "sprcost: '%s' isn't the same size as the first frame\n", argv[arg + i]);
+            return 1;
+        }
+    }
+
+    int w = frames[0].w, h = frames[0].h;
+    int x0 = 0, y0 = 0, x1 = w - 1, y1 = h - 1;
+    if (crop) {
+        x0 = w; y0 = h; x1 = -1; y1 = -1;
+        for (int i = 0; i < numFrames; i++) {
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    if (!frames[i].pixels[y*w + x]) continue;
+                    if (x < x0) x0 = x;
+                    if (x > x1) x1 = x;
+                    if (y < y0) y0 = y;
+                    if (y > y1) y1 = y;
+                }
+            }
+        }
+        if (x1 < 0) {
+            x0 = y0 = 0;
+            x1 = y1 = 0;
+        }
+    }
+
+    int stripes = (w + STRIPE_WIDTH - 1) / STRIPE_WIDTH;
+    int blitData = numFrames*stripes*(STRIPE_WIDTH*h + 1);
+    int blitLuts = numFrames*(stripes*4 + 2) + numFrames*2;
+    int blitCycles = stripes*h*SPRITE6_CYCLES;
+
+    int pw = x1 - x0 + 1, ph = y1 - y0 + 1;
+    int patData = numFrames*(pw*ph + 2);
+    int patLuts = numFrames*2;
+    int slot = pw*ph*2 + 4;
+    int drawCycles = ph*(DRAWSPRITE_CYCLES + RESTORE_CYCLES);
+    int animCycles = ph*PATTERN_CYCLES;
+
+    printf("%d frame(s) of %dx%d", numFrames, w, h);
+    if (crop) printf(", patterns cropped to %dx%d", pw, ph);
+    printf("\n\n");
+    printf("                  %8s %8s\n", "blit", "pattern");
+    printf("  data bytes      %8d %8d\n", blitData, patData);
+    printf("  lut bytes       %8d %8d\n", blitLuts, patLuts);
+    printf("  sprite slot     %8d %8d\n", 0, slot);
+    printf("  total bytes     %8d %8d\n", blitData + blitLuts, patData + patLuts + slot);
+    printf("  draw cycles     %8d %8d   (pattern = draw + restore)\n", blitCycles, drawCycles);
+    printf("  frame change    %8d %8d\n", 0, animCycles);
+
+    return 0;
+}
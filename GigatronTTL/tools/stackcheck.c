@@ -0,0 +1,642 @@
+// stackcheck - static vCPU stack depth and register4..7 check for time slicing
+//
+// Build: cc -O2 -o stackcheck stackcheck.c
+// Usage: stackcheck [-m label] [-r proc]... <sugarglider.gasm>
+//
+// Reads the code of an assembled .gasm, (the game and the internal runtime past
+// its banner), expands the runtime macros it uses from its %include files and
+// follows every CALLI, (and CALL giga_vAC straight after an LDWI of a label),
+// from the main loop, (-m, defaults to _loop), and from every real time proc.
+// Real time procs are the ones whose address is stored into realTimeProc0..2
+// before setRealTimeProc, plus any named with -r, (so a proc can be checked
+// before time slicing is turned on for it).
+//
+// Each proc is walked along every branch with the number of bytes PUSH has put
+// on the stack, the deepest call chain is printed for the main loop and for
+// the real time procs, which run on top of whatever the main loop has pushed
+// plus the PUSH of realTimeStub. The worst case of the two is compared against
+// the zero page left above the highest variable, (the stack grows down from
+// 0x00ff). Procs that reach a RET with vLR overwritten by a call and not saved,
+// or that join the same instruction with different stack depths, are listed.
+//
+// The runtime keeps register4 to register7 for real time code, so every write
+// to them from code reachable from the main loop is listed, as is every write
+// from real time code to the other registers or to sysFn/sysArgs, (the vertical
+// blank interrupt only saves vAC and vPC). Writes through pointers, (POKE, DOKE
+// and SYS calls), aren't followed and calls through tables are only counted.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_SYMBOLS     4096
+#define MAX_MACROS      256
+#define MAX_MACRO_LINES 32
+#define MAX_INSTRS      16384
+#define MAX_ROOTS       8
+#define MAX_OPERANDS    4
+
+#define REGISTER0       0x82
+#define REGISTERS_SIZE  0x2C    // register0..register15, fgbgColour..miscFlags and register16
+#define REGISTER4       (REGISTER0 + 0x08)
+#define REGISTER8       (REGISTER0 + 0x10)
+#define SYS_START       0x22    // giga_sysFn
+#define SYS_END         0x2C    // past giga_sysArg7
+
+typedef struct {
+    char name[64];
+    char expr[64];
+    int evaluating;
+} symbol_t;
+
+typedef struct {
+    char name[32];
+    char params[MAX_OPERANDS][32];
+    int numParams;
+    char lines[MAX_MACRO_LINES][128];
+    int numLines;
+} macro_t;
+
+typedef struct {
+    char label[64];
+    char op[16];
+    char operands[MAX_OPERANDS][64];
+    int numOperands;
+    int line;
+    int jump;       // a CALLI that is a goto or a page crossing rather than a call
+} instr_t;
+
+enum {UNVISITED = 0, VISITING, VISITED};
+
+typedef struct {
+    int state;
+    int pushed;     // most bytes pushed by the proc itself
+    int depth;      // most bytes pushed by the proc and its deepest callee
+    int deepest;    // instruction index of the deepest callee, -1 for none
+} proc_t;
+
+static symbol_t symbols[MAX_SYMBOLS];
+static macro_t  macros[MAX_MACROS];
+static instr_t  instrs[MAX_INSTRS];
+static proc_t   procs[MAX_INSTRS];      // indexed by the entry instruction
+static uint8_t  reachedMain[MAX_INSTRS], reachedRealTime[MAX_INSTRS];
+static int numSymbols = 0, numMacros = 0, numInstrs = 0;
+static int zeroPageTop = 0;
+
+// Destination operand and width of the instructions that write a variable, (the variable itself, not what it points to)
+static const struct {
+    const char *op;
+    int operand;
+    int width;
+} writes[] = {
+    {"STW", 0, 2}, {"ST", 0, 1}, {"INC", 0, 1}, {"DEC", 0, 1}, {"INCW", 0, 2}, {"DECW", 0, 2},
+    {"MOVQB", 0, 1}, {"MOVQW", 0, 2}, {"MOVB", 1, 1}, {"MOVWA", 1, 2},
+    {"ADDVI", 1, 2}, {"SUBVI", 1, 2}, {"ADDVW", 2, 2}, {"SUBVW", 2, 2}, {"ADDBI", 1, 1}, {"SUBBI", 1, 1},
+    {"ANDBI", 0, 1}, {"ORBI", 0, 1}, {"XORBI", 0, 1}, {"NEGW", 0, 2}, {"ABSVW", 0, 2},
+    {"DBNE", 0, 1}, {"DBGE", 0, 1}, {"DEEKV+", 0, 2}, {"PEEKV+", 0, 2}, {"DEEKA", 0, 2}, {"PEEKA", 0, 1},
+    {"TEQ", 0, 2}, {"TNE", 0, 2}, {"TLT", 0, 2}, {"TGT", 0, 2}, {"TLE", 0, 2}, {"TGE", 0, 2},
+    {NULL, 0, 0}
+};
+
+// Instructions whose first operand is a value rather than a variable
+static const char *immediates[] = {
+    "LDI", "LDWI", "LDNI", "ADDI", "SUBI", "ANDI", "ORI", "XORI", "SYS", "LUP", "CALLI", "ARRW", NULL
+};
+
+static int isOp(const char *op, const char *const *list) {
+    for (int i = 0; list[i]; i++) {
+        if (strcmp(op, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = 0;
+    return s;
+}
+
+static symbol_t *findSymbol(const char *name) {
+    for (int i = 0; i < numSymbols; i++) {
+        if (strcmp(symbols[i].name, name) == 0) return &symbols[i];
+    }
+    return NULL;
+}
+
+static void addSymbol(const char *name, const char *expr) {
+    if (numSymbols == MAX_SYMBOLS || findSymbol(name)) return;
+    symbol_t *s = &symbols[numSymbols++];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    snprintf(s->expr, sizeof(s->expr), "%s", expr);
+}
+
+// Sums and differences of numbers and symbols, -1 when any part of it isn't known
+static int evaluate(const char *expr) {
+    char buf[64], term[64];
+    snprintf(buf, sizeof(buf), "%s", expr);
+
+    int value = 0, sign = 1;
+    const char *p = buf;
+    while (*p) {
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '+' || *p == '-') {
+            sign = (*p == '-') ? -1 : 1;
+            p++;
+            continue;
+        }
+
+        int n = 0;
+        while (*p && !isspace((unsigned char)*p) && *p != '+' && *p != '-' && n < 63) term[n++] = *p++;
+        term[n] = 0;
+        if (n == 0) break;
+
+        int v;
+        if (isdigit((unsigned char)term[0])) {
+            v = (int)strtol(term, NULL, 0);
+        } else if (term[0] == '&' && (term[1] == 'h' || term[1] == 'H')) {
+            v = (int)strtol(term + 2, NULL, 16);
+        } else {
+            symbol_t *s = findSymbol(term);
+            if (!s || s->evaluating) return -1;
+            s->evaluating = 1;
+            v = evaluate(s->expr);
+            s->evaluating = 0;
+        }
+        if (v < 0) return -1;
+        value += sign*v;
+        sign = 1;
+    }
+
+    return value;
+}
+
+static macro_t *findMacro(const char *name) {
+    for (int i = 0; i < numMacros; i++) {
+        if (strcmp(macros[i].name, name) == 0) return &macros[i];
+    }
+    return NULL;
+}
+
+// Label, mnemonic and comma separated operands, (whitespace separated for macros), of one line
+static int splitLine(char *line, char *label, char *op, char operands[][64], int *numOperands) {
+    char *semi = strchr(line, ';');
+    if (semi) *semi = 0;
+
+    label[0] = op[0] = 0;
+    *numOperands = 0;
+    char *p = line;
+    if (!isspace((unsigned char)*p) && *p) {
+        int n = 0;
+        while (*p && !isspace((unsigned char)*p) && n < 63) label[n++] = *p++;
+        label[n] = 0;
+    }
+
+    while (isspace((unsigned char)*p)) p++;
+    int n = 0;
+    while (*p && !isspace((unsigned char)*p) && n < 15) op[n++] = *p++;
+    op[n] = 0;
+
+    p = trim(p);
+    if (!*p) return label[0] || op[0];
+    const char *sep = strchr(p, ',') ? "," : (findMacro(op) ? " \t" : ",");
+    for (char *tok = strtok(p, sep); tok && *numOperands < MAX_OPERANDS; tok = strtok(NULL, sep)) {
+        snprintf(operands[(*numOperands)++], 64, "%s", trim(tok));
+    }
+
+    return 1;
+}
+
+static void loadInclude(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "stackcheck: can't open '%s'\n", path);
+        return;
+    }
+
+    char line[256];
+    macro_t *m = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\r\n")] = 0;
+        if (m) {
+            if (strncmp(line, "%ENDM", 5) == 0) {
+                m = NULL;
+            } else if (m->numLines < MAX_MACRO_LINES) {
+                snprintf(m->lines[m->numLines++], sizeof(m->lines[0]), "%.127s", line);
+            }
+            continue;
+        }
+
+        if (strncmp(line, "%MACRO", 6) == 0 && numMacros < MAX_MACROS) {
+            m = &macros[numMacros++];
+            char *tok = strtok(line + 6, " \t");
+            snprintf(m->name, sizeof(m->name), "%s", tok ? tok : "");
+            while ((tok = strtok(NULL, " \t")) && m->numParams < MAX_OPERANDS) {
+                snprintf(m->params[m->numParams++], sizeof(m->params[0]), "%s", tok);
+            }
+            continue;
+        }
+
+        char label[64], op[16], arg[64];
+        if (sscanf(line, "%63s %15s %63[^;]", label, op, arg) == 3 && strcmp(op, "EQU") == 0) addSymbol(label, trim(arg));
+    }
+
+    fclose(fp);
+}
+
+static void addInstr(const char *label, const char *op, char operands[][64], int numOperands, int line) {
+    if (numInstrs == MAX_INSTRS) return;
+    instr_t *in = &instrs[numInstrs++];
+    snprintf(in->label, sizeof(in->label), "%s", label);
+    snprintf(in->op, sizeof(in->op), "%s", op);
+    for (int i = 0; i < numOperands; i++) snprintf(in->operands[i], sizeof(in->operands[0]), "%s", operands[i]);
+    in->numOperands = numOperands;
+    in->line = line;
+}
+
+// Macro bodies have no labels of their own, their parameters are whole operands
+static void expandMacro(const macro_t *m, const char *label, char args[][64], int numArgs, int line) {
+    const char *pending = label;
+    for (int i = 0; i < m->numLines; i++) {
+        char body[128], l[64], op[16], operands[MAX_OPERANDS][64];
+        int numOperands;
+        snprintf(body, sizeof(body), "%s", m->lines[i]);
+        if (!splitLine(body, l, op, operands, &numOperands) || !op[0]) continue;
+
+        for (int j = 0; j < numOperands; j++) {
+            for (int k = 0; k < m->numParams && k < numArgs; k++) {
+                if (strcmp(operands[j], m->params[k]) == 0) snprintf(operands[j], sizeof(operands[0]), "%.63s", args[k]);
+            }
+        }
+        addInstr(pending, op, operands, numOperands, line);
+        pending = "";
+    }
+}
+
+static int loadGasm(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "stackcheck: can't open '%s'\n", path);
+        return 0;
+    }
+
+    char dir[256] = ".", includePath[256] = "";
+    const char *slash = strrchr(path, '/');
+    if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+
+    char line[4096], section[64] = "", pendingLabel[64] = "";
+    int lineNum = 0, code = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineNum++;
+        line[strcspn(line, "\r\n")] = 0;
+        if (line[0] == ';') {
+            if (line[1] == ' ') sscanf(line + 2, "%63[^\r\n]", section);
+            if (strncmp(section, "Code", 4) == 0) code = 1;
+            continue;
+        }
+
+        if (line[0] == '%') {
+            char directive[32], arg[200];
+            if (sscanf(line, "%31s %199s", directive, arg) != 2) continue;
+            if (strcmp(directive, "%includePath") == 0) {
+                char *name = (arg[0] == '"') ? arg + 1 : arg;
+                name[strcspn(name, "\"")] = 0;
+                snprintf(includePath, sizeof(includePath), "%s/%s", dir, name);
+                if (includePath[strlen(includePath) - 1] == '/') includePath[strlen(includePath) - 1] = 0;
+            } else if (strcmp(directive, "%include") == 0) {
+                char inc[512];
+                snprintf(inc, sizeof(inc), "%s/%s", includePath[0] ? includePath : dir, arg);
+                loadInclude(inc);
+            }
+            continue;
+        }
+
+        // the compiler uses CALLI for far gotos too, its comment is the only thing that tells them apart
+        int isGoto = (strstr(line, "; goto") != NULL);
+        char label[64], op[16], operands[MAX_OPERANDS][64];
+        int numOperands;
+        if (!splitLine(line, label, op, operands, &numOperands)) continue;
+
+        if (strcmp(op, "EQU") == 0) {
+            if (numOperands) {
+                addSymbol(label, operands[0]);
+                int addr = evaluate(operands[0]);
+                if (strstr(section, "Variables") && addr >= 0 && addr < 0x100 && addr + 1 > zeroPageTop) zeroPageTop = addr + 1;
+            }
+            continue;
+        }
+        if (!code || strcmp(op, "DB") == 0 || strcmp(op, "DW") == 0) continue;
+
+        // a label on a line of its own belongs to the next instruction
+        if (!op[0]) {
+            snprintf(pendingLabel, sizeof(pendingLabel), "%s", label);
+            continue;
+        }
+        if (!label[0] && pendingLabel[0]) snprintf(label, sizeof(label), "%s", pendingLabel);
+        pendingLabel[0] = 0;
+
+        const macro_t *m = findMacro(op);
+        if (m) {
+            expandMacro(m, label, operands, numOperands, lineNum);
+        } else {
+            addInstr(label, op, operands, numOperands, lineNum);
+            instrs[numInstrs - 1].jump = isGoto && strcmp(op, "CALLI") == 0;
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static int isFlowLabel(const char *name) {
+    const char *hex = strstr(name, "_0x");
+    if (name[0] != '_' || !hex || strlen(hex) != 7) return 0;
+    for (const char *p = hex + 3; *p; p++) {
+        if (!isxdigit((unsigned char)*p)) return 0;
+    }
+    return 1;
+}
+
+static int findLabel(const char *name) {
+    for (int i = 0; i < numInstrs; i++) {
+        if (strcmp(instrs[i].label, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int branchOperand(int i) {
+    const char *op = instrs[i].op;
+    if (instrs[i].jump) return 0;
+    if (strcmp(op, "DBNE") == 0 || strcmp(op, "DBGE") == 0) return 1;
+    if ((op[0] == 'B' || op[0] == 'J') && strlen(op) == 3) return 0;
+    return -1;
+}
+
+// Entry instruction of a call, -1 for calls through a table
+static int callTarget(int i) {
+    const instr_t *in = &instrs[i];
+    if (strcmp(in->op, "CALLI") == 0 && in->numOperands) return findLabel(in->operands[0]);
+    if (strcmp(in->op, "CALL") == 0 && i > 0 && strcmp(instrs[i - 1].op, "LDWI") == 0) return findLabel(instrs[i - 1].operands[0]);
+    return -1;
+}
+
+static int isCall(int i) {
+    return (strcmp(instrs[i].op, "CALLI") == 0 || strcmp(instrs[i].op, "CALL") == 0) && !instrs[i].jump;
+}
+
+// RTI is LDWI 0x0400 then LUP 0
+static int isExit(int i) {
+    const char *op = instrs[i].op;
+    if (instrs[i].jump) return 1;
+    if (strcmp(op, "RET") == 0 || strcmp(op, "HALT") == 0 || strcmp(op, "BRA") == 0) return 1;
+    return strcmp(op, "LUP") == 0 && i > 0 && strcmp(instrs[i - 1].op, "LDWI") == 0 && evaluate(instrs[i - 1].operands[0]) == 0x0400;
+}
+
+static const char *procName(int entry) {
+    for (int i = entry; i >= 0; i--) {
+        if (instrs[i].label[0]) return instrs[i].label;
+    }
+    return "?";
+}
+
+static void walk(int entry);
+
+// Every path through a proc, with the bytes pushed and whether vLR has been overwritten since
+static void walkProc(int entry) {
+    proc_t *p = &procs[entry];
+    p->state = VISITING;
+    p->deepest = -1;
+
+    int *depths = malloc(sizeof(int)*numInstrs);
+    int *todo = malloc(sizeof(int)*numInstrs*3);
+    for (int i = 0; i < numInstrs; i++) depths[i] = -1;
+
+    int top = 0, reportedJoin = 0, reportedLR = 0;
+    todo[top++] = entry, todo[top++] = 0, todo[top++] = 0;
+    while (top) {
+        int called = todo[--top], depth = todo[--top], i = todo[--top];
+        while (i >= 0 && i < numInstrs) {
+            if (depths[i] >= 0) {
+                if (depths[i] != depth && !reportedJoin) {
+                    printf("  %s: line %d is reached with %d and %d bytes pushed\n", procName(entry), instrs[i].line, depths[i], depth);
+                    reportedJoin = 1;
+                }
+                break;
+            }
+            depths[i] = depth;
+
+            const instr_t *in = &instrs[i];
+            if (strcmp(in->op, "PUSH") == 0) {
+                depth += 2;
+                called = 0;
+            } else if (strcmp(in->op, "POP") == 0) {
+                depth -= 2;
+            }
+            if (depth > p->pushed) p->pushed = depth;
+            if (depth > p->depth) p->depth = depth;
+
+            if (isCall(i)) {
+                int target = callTarget(i);
+                if (target >= 0) {
+                    walk(target);
+                    if (procs[target].state == VISITING) {
+                        printf("  %s: line %d calls %s recursively\n", procName(entry), in->line, procName(target));
+                    } else if (depth + procs[target].depth > p->depth) {
+                        p->depth = depth + procs[target].depth;
+                        p->deepest = i;
+                    }
+                }
+                if (depth == 0) called = 1;
+            }
+
+            if (strcmp(in->op, "RET") == 0 && called && !reportedLR) {
+                printf("  %s: line %d returns with vLR overwritten by a call\n", procName(entry), in->line);
+                reportedLR = 1;
+            }
+
+            int b = branchOperand(i);
+            if (b >= 0 && b < in->numOperands && top + 3 <= numInstrs*3) {
+                int target = findLabel(in->operands[b]);
+                if (target >= 0) todo[top++] = target, todo[top++] = depth, todo[top++] = called;
+            }
+
+            if (isExit(i)) break;
+            i++;
+        }
+    }
+
+    free(todo);
+    free(depths);
+    p->state = VISITED;
+}
+
+static void walk(int entry) {
+    if (procs[entry].state == UNVISITED) walkProc(entry);
+}
+
+// Every instruction that can run from entry, calls included
+static void reach(int entry, uint8_t *reached) {
+    int *todo = malloc(sizeof(int)*numInstrs);
+    int top = 0;
+    todo[top++] = entry;
+    while (top) {
+        int i = todo[--top];
+        while (i >= 0 && i < numInstrs && !reached[i]) {
+            reached[i] = 1;
+            const instr_t *in = &instrs[i];
+            if (isCall(i)) {
+                int target = callTarget(i);
+                if (target >= 0 && !reached[target]) reach(target, reached);
+            }
+
+            int b = branchOperand(i);
+            if (b >= 0 && b < in->numOperands && top < numInstrs) {
+                int target = findLabel(in->operands[b]);
+                if (target >= 0) todo[top++] = target;
+            }
+
+            if (isExit(i)) break;
+            i++;
+        }
+    }
+    free(todo);
+}
+
+static void printChain(int entry) {
+    printf("%s", procName(entry));
+    while (procs[entry].deepest >= 0) {
+        entry = callTarget(procs[entry].deepest);
+        printf(" > %s", procName(entry));
+    }
+    printf("\n");
+}
+
+// Direct writes of every reached instruction that fall in [start, end) but not [skipStart, skipEnd)
+static int listWrites(const uint8_t *reached, int start, int end, int skipStart, int skipEnd, int sys) {
+    int n = 0;
+    for (int i = 0; i < numInstrs; i++) {
+        if (!reached[i]) continue;
+        const instr_t *in = &instrs[i];
+        if (sys && strcmp(in->op, "SYS") == 0) {
+            printf("  %-24s line %5d  SYS %s\n", procName(i), in->line, in->numOperands ? in->operands[0] : "");
+            n++;
+            continue;
+        }
+
+        for (int w = 0; writes[w].op; w++) {
+            if (strcmp(in->op, writes[w].op) != 0 || writes[w].operand >= in->numOperands) continue;
+            int addr = evaluate(in->operands[writes[w].operand]);
+            if (addr < 0) break;
+            if (addr + writes[w].width > start && addr < end && !(addr >= skipStart && addr + writes[w].width <= skipEnd)) {
+                printf("  %-24s line %5d  %s %s\n", procName(i), in->line, in->op, in->operands[writes[w].operand]);
+                n++;
+            }
+            break;
+        }
+    }
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    const char *mainLabel = "_loop";
+    const char *roots[MAX_ROOTS];
+    int numRoots = 0, arg = 1;
+    for (; arg < argc - 1; arg += 2) {
+        if (strcmp(argv[arg], "-m") == 0) {
+            mainLabel = argv[arg + 1];
+        } else if (strcmp(argv[arg], "-r") == 0 && numRoots < MAX_ROOTS) {
+            roots[numRoots++] = argv[arg + 1];
+        } else {
+            break;
+        }
+    }
+    if (arg != argc - 1) {
+        fprintf(stderr, "Usage: stackcheck [-m label] [-r proc]... <sugarglider.gasm>\n");
+        return 1;
+    }
+
+    if (!loadGasm(argv[arg])) return 1;
+
+    // far branches of ifs, loops and page crossings are CALLIs to the compiler's own _name_0xnnnn labels
+    for (int i = 0; i < numInstrs; i++) {
+        if (strcmp(instrs[i].op, "CALLI") == 0 && instrs[i].numOperands && isFlowLabel(instrs[i].operands[0])) instrs[i].jump = 1;
+    }
+
+    // procs handed to setRealTimeProc, (LDWI proc, STW realTimeProcN)
+    for (int i = 1; i < numInstrs && numRoots < MAX_ROOTS; i++) {
+        if (strcmp(instrs[i].op, "STW") == 0 && instrs[i].numOperands && strncmp(instrs[i].operands[0], "realTimeProc", 12) == 0 &&
+            strcmp(instrs[i - 1].op, "LDWI") == 0 && findLabel(instrs[i - 1].operands[0]) >= 0) {
+            roots[numRoots++] = instrs[i - 1].operands[0];
+        }
+    }
+
+    // expression temporaries and any other direct zero page operand are part of the variables the stack must stay above
+    for (int i = 0; i < numInstrs; i++) {
+        const instr_t *in = &instrs[i];
+        if (isOp(in->op, immediates) || branchOperand(i) >= 0 || !in->numOperands || !isdigit((unsigned char)in->operands[0][0])) continue;
+        int addr = evaluate(in->operands[0]);
+        if (addr >= 0x30 && addr < 0x100 && addr + 2 > zeroPageTop) zeroPageTop = addr + 2;
+    }
+
+    int mainEntry = findLabel(mainLabel);
+    if (mainEntry < 0) {
+        fprintf(stderr, "stackcheck: no '%s' in '%s'\n", mainLabel, argv[arg]);
+        return 1;
+    }
+
+    printf("paths:\n");
+    walk(mainEntry);
+    reach(mainEntry, reachedMain);
+    int realTimeDepth = -1, realTimeEntry = -1;
+    for (int r = 0; r < numRoots; r++) {
+        int entry = findLabel(roots[r]);
+        if (entry < 0) {
+            fprintf(stderr, "stackcheck: no real time proc '%s'\n", roots[r]);
+            return 1;
+        }
+        walk(entry);
+        reach(entry, reachedRealTime);
+        if (procs[entry].depth > realTimeDepth) {
+            realTimeDepth = procs[entry].depth;
+            realTimeEntry = entry;
+        }
+    }
+
+    int calls = 0, unresolved = 0;
+    for (int i = 0; i < numInstrs; i++) {
+        if (!(reachedMain[i] || reachedRealTime[i]) || !isCall(i)) continue;
+        calls++;
+        if (callTarget(i) < 0) unresolved++;
+    }
+    printf("  %d calls followed, %d through tables not followed\n", calls - unresolved, unresolved);
+
+    // realTimeStub pushes vLR before calling the proc
+    int worst = procs[mainEntry].depth + ((realTimeEntry >= 0) ? 2 + realTimeDepth : 0);
+    int room = 0x100 - zeroPageTop;
+    printf("\nstack, (bytes):\n");
+    printf("  %-24s %5d  ", "main", procs[mainEntry].depth);
+    printChain(mainEntry);
+    if (realTimeEntry >= 0) {
+        printf("  %-24s %5d  ", "real time", 2 + realTimeDepth);
+        printChain(realTimeEntry);
+    } else {
+        printf("  %-24s %5s  none found, (-r to name one)\n", "real time", "-");
+    }
+    printf("  %-24s %5d  of %d free above 0x%02x%s\n", "worst case", worst, room, zeroPageTop - 1, (worst > room) ? ", OVERFLOWS" : "");
+
+    printf("\nregister4..register7 written by main code:\n");
+    int clobbers = listWrites(reachedMain, REGISTER4, REGISTER8, 0, 0, 0);
+    if (!clobbers) printf("  none\n");
+
+    int unsafe = 0;
+    if (realTimeEntry >= 0) {
+        printf("\nregisters and sysFn/sysArgs written by real time code, (only register4..register7 are free):\n");
+        unsafe = listWrites(reachedRealTime, REGISTER0, REGISTER0 + REGISTERS_SIZE, REGISTER4, REGISTER8, 1);
+        unsafe += listWrites(reachedRealTime, SYS_START, SYS_END, 0, 0, 0);
+        if (!unsafe) printf("  none\n");
+    }
+
+    return (worst > room || (realTimeEntry >= 0 && (clobbers || unsafe))) ? 1 : 0;
+}